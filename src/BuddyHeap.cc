@@ -0,0 +1,194 @@
+#include "BuddyHeap.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace s21 {
+
+BuddyHeap::BuddyHeap(std::size_t order)
+    : order_(order),
+      memory_(static_cast<std::byte *>(
+          std::aligned_alloc(Capacity(), Capacity()))),
+      free_bits_((std::size_t{2} << (order - min_order)) / 64 + 1),
+      split_bits_(free_bits_.size()) {
+  if (!memory_) throw std::bad_alloc();
+  Push(0, order);
+}
+
+void BuddyHeap::MemoryDeleter::operator()(std::byte *memory) const noexcept {
+  std::free(memory);
+}
+
+std::unique_ptr<BuddyHeap> BuddyHeap::Create(std::size_t size) {
+  if (size > std::size_t{1} << max_order) {
+    throw std::runtime_error("Heap size is too big");
+  }
+  return std::unique_ptr<BuddyHeap>(new BuddyHeap(Order(size)));
+}
+
+void *BuddyHeap::Malloc(std::size_t size) {
+  if (size > Capacity()) return nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  return Allocate(Order(size));
+}
+
+// A block is aligned to its own size, so the alignment only raises the
+// size of the block.
+void *BuddyHeap::AlignedMalloc(std::size_t alignment, std::size_t size) {
+  if (!alignment || alignment & (alignment - 1)) {
+    throw std::invalid_argument("Alignment is not a power of two");
+  }
+  return Malloc(std::max(size, alignment));
+}
+
+void *BuddyHeap::Calloc(std::size_t num, std::size_t size) {
+  std::size_t total_size;
+  if (__builtin_mul_overflow(num, size, &total_size)) return nullptr;
+  auto ptr = Malloc(total_size);
+  if (ptr) std::memset(ptr, 0, total_size);
+  return ptr;
+}
+
+// Shrinking gives the upper halves back to the free lists; growing moves
+// the data to a new block.
+void *BuddyHeap::Realloc(void *ptr, std::size_t size) {
+  if (!ptr) return Malloc(size);
+  if (size > Capacity()) return nullptr;
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto order = FindOrder(ptr);
+  auto new_order = Order(size);
+  if (new_order <= order) {
+    auto offset = static_cast<std::size_t>(static_cast<std::byte *>(ptr) -
+                                           memory_.get());
+    for (; order > new_order; --order) {
+      Set(split_bits_, Node(offset, order), true);
+      Release(offset + (std::size_t{1} << (order - 1)), order - 1);
+    }
+    return ptr;
+  }
+  auto new_ptr = Allocate(new_order);
+  if (new_ptr) {
+    std::memcpy(new_ptr, ptr, std::size_t{1} << order);
+    Release(static_cast<std::byte *>(ptr) - memory_.get(), order);
+  }
+  return new_ptr;
+}
+
+void BuddyHeap::Free(void *ptr) {
+  if (!ptr) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Release(static_cast<std::byte *>(ptr) - memory_.get(), FindOrder(ptr));
+}
+
+std::size_t BuddyHeap::UsableSize(void *ptr) {
+  if (!ptr) return 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::size_t{1} << FindOrder(ptr);
+}
+
+std::size_t BuddyHeap::Capacity() const noexcept {
+  return std::size_t{1} << order_;
+}
+
+std::size_t BuddyHeap::BytesInUse() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_in_use_;
+}
+
+std::size_t BuddyHeap::Order(std::size_t size) noexcept {
+  if (size <= std::size_t{1} << min_order) return min_order;
+  return 64 - __builtin_clzll(size - 1);
+}
+
+// Blocks are numbered level by level from the whole heap down, as in a
+// binary heap, so the children of node i are 2i + 1 and 2i + 2.
+std::size_t BuddyHeap::Node(std::size_t offset,
+                            std::size_t order) const noexcept {
+  return (std::size_t{1} << (order_ - order)) - 1 + (offset >> order);
+}
+
+bool BuddyHeap::Test(const std::vector<std::uint64_t> &bits,
+                     std::size_t node) noexcept {
+  return bits[node / 64] >> (node % 64) & 1;
+}
+
+void BuddyHeap::Set(std::vector<std::uint64_t> &bits, std::size_t node,
+                    bool value) noexcept {
+  auto bit = std::uint64_t{1} << (node % 64);
+  bits[node / 64] = value ? bits[node / 64] | bit : bits[node / 64] & ~bit;
+}
+
+// Takes the smallest free block of the order or above and splits it down,
+// putting the upper half of every split back on the free lists.
+std::byte *BuddyHeap::Allocate(std::size_t order) noexcept {
+  auto larger = order <= order_ ? non_empty_orders_ >> order : 0;
+  if (!larger) return nullptr;
+  auto found = order + __builtin_ctzll(larger);
+  auto block = reinterpret_cast<std::byte *>(free_lists_[found]);
+  auto offset = static_cast<std::size_t>(block - memory_.get());
+  Unlink(offset, found);
+  for (; found > order; --found) {
+    Set(split_bits_, Node(offset, found), true);
+    Push(offset + (std::size_t{1} << (found - 1)), found - 1);
+  }
+  bytes_in_use_ += std::size_t{1} << order;
+  return block;
+}
+
+// Merges the block with its buddy for as long as the buddy is free.
+void BuddyHeap::Release(std::size_t offset, std::size_t order) noexcept {
+  bytes_in_use_ -= std::size_t{1} << order;
+  for (; order < order_; ++order) {
+    auto buddy = offset ^ (std::size_t{1} << order);
+    if (!Test(free_bits_, Node(buddy, order))) break;
+    Unlink(buddy, order);
+    offset = std::min(offset, buddy);
+    Set(split_bits_, Node(offset, order + 1), false);
+  }
+  Push(offset, order);
+}
+
+void BuddyHeap::Push(std::size_t offset, std::size_t order) noexcept {
+  auto block = reinterpret_cast<FreeBlock *>(memory_.get() + offset);
+  block->next = free_lists_[order];
+  block->prev = nullptr;
+  if (block->next) block->next->prev = block;
+  free_lists_[order] = block;
+  non_empty_orders_ |= std::uint64_t{1} << order;
+  Set(free_bits_, Node(offset, order), true);
+}
+
+void BuddyHeap::Unlink(std::size_t offset, std::size_t order) noexcept {
+  auto block = reinterpret_cast<FreeBlock *>(memory_.get() + offset);
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    free_lists_[order] = block->next;
+  }
+  if (block->next) block->next->prev = block->prev;
+  if (!free_lists_[order]) non_empty_orders_ &= ~(std::uint64_t{1} << order);
+  Set(free_bits_, Node(offset, order), false);
+}
+
+// Walks down from the whole heap through split blocks to the block that
+// starts at the pointer.
+std::size_t BuddyHeap::FindOrder(const void *ptr) const {
+  auto byte = static_cast<const std::byte *>(ptr);
+  if (byte < memory_.get() || byte >= memory_.get() + Capacity()) {
+    throw std::runtime_error("wrong pointer");
+  }
+  auto offset = static_cast<std::size_t>(byte - memory_.get());
+  auto order = order_;
+  while (order > min_order && Test(split_bits_, Node(offset, order))) --order;
+  auto node = Node(offset, order);
+  if (offset & ((std::size_t{1} << order) - 1) || Test(split_bits_, node) ||
+      Test(free_bits_, node)) {
+    throw std::runtime_error("wrong pointer");
+  }
+  return order;
+}
+
+}  // namespace s21
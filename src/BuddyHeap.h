@@ -0,0 +1,73 @@
+#ifndef MEMORY_BUDDY_HEAP_H
+#define MEMORY_BUDDY_HEAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace s21 {
+// Binary buddy allocator. Blocks are powers of two placed at multiples of
+// their size, so the buddy of a block is found from its offset alone. The
+// state of every block is kept in two bitmaps over the tree of blocks
+// instead of a header: whether a block is free and whether it is split.
+class BuddyHeap {
+ public:
+  constexpr static std::size_t min_order = 4;
+  constexpr static std::size_t max_order = 40;
+
+  BuddyHeap(const BuddyHeap&) = delete;
+  BuddyHeap& operator=(const BuddyHeap&) = delete;
+
+  // The size is rounded up to a power of two.
+  static std::unique_ptr<BuddyHeap> Create(std::size_t size);
+  void* Malloc(std::size_t size);
+  void* AlignedMalloc(std::size_t alignment, std::size_t size);
+  void* Calloc(std::size_t num, std::size_t size);
+  void* Realloc(void* ptr, std::size_t size);
+  void Free(void* ptr);
+  std::size_t UsableSize(void* ptr);
+  std::size_t Capacity() const noexcept;
+  std::size_t BytesInUse();
+
+ private:
+  explicit BuddyHeap(std::size_t order);
+
+  // Lies in the first bytes of a free block.
+  struct FreeBlock {
+    FreeBlock* next;
+    FreeBlock* prev;
+  };
+
+  static std::size_t Order(std::size_t size) noexcept;
+  std::size_t Node(std::size_t offset, std::size_t order) const noexcept;
+  static bool Test(const std::vector<std::uint64_t>& bits,
+                   std::size_t node) noexcept;
+  static void Set(std::vector<std::uint64_t>& bits, std::size_t node,
+                  bool value) noexcept;
+  std::byte* Allocate(std::size_t order) noexcept;
+  void Release(std::size_t offset, std::size_t order) noexcept;
+  void Push(std::size_t offset, std::size_t order) noexcept;
+  void Unlink(std::size_t offset, std::size_t order) noexcept;
+  std::size_t FindOrder(const void* ptr) const;
+
+  struct MemoryDeleter {
+    void operator()(std::byte* memory) const noexcept;
+  };
+
+  std::size_t order_;
+  // Aligned to its size, so that every block is aligned to its own size.
+  std::unique_ptr<std::byte, MemoryDeleter> memory_;
+  std::array<FreeBlock*, max_order + 1> free_lists_{};
+  std::uint64_t non_empty_orders_ = 0;
+  std::vector<std::uint64_t> free_bits_;
+  std::vector<std::uint64_t> split_bits_;
+  std::size_t bytes_in_use_ = 0;
+  std::mutex mutex_;
+};
+
+}  // namespace s21
+
+#endif  // MEMORY_BUDDY_HEAP_H
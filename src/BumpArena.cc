@@ -0,0 +1,59 @@
+#include "BumpArena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace s21 {
+
+BumpArena::BumpArena() : BumpArena(Heap::GetInstance()) {}
+
+BumpArena::BumpArena(Heap &heap, std::size_t block_size)
+    : heap_(&heap), block_size_(block_size) {
+  first_ = current_ = NewBlock(block_size);
+  if (!first_) throw std::bad_alloc();
+  first_->next = nullptr;
+}
+
+BumpArena::~BumpArena() {
+  for (Block *block = first_, *next; block; block = next) {
+    next = block->next;
+    heap_->Free(block);
+  }
+}
+
+BumpArena::Mark BumpArena::GetMark() const noexcept {
+  return {current_, offset_};
+}
+
+void BumpArena::Rewind(Mark mark) noexcept {
+  current_ = mark.block;
+  offset_ = mark.offset;
+}
+
+void BumpArena::Reset() noexcept { Rewind({first_, 0}); }
+
+// Blocks left behind by a rewind are used again before new ones are taken.
+// A new block goes right after the current one, so that a smaller block
+// kept further on is still used later.
+void *BumpArena::AllocateInNextBlock(std::size_t size, std::size_t alignment) {
+  auto mark = GetMark();
+  if (current_->next) {
+    Rewind({current_->next, 0});
+    if (auto ptr = Bump(size, alignment)) return ptr;
+    Rewind(mark);
+  }
+  if (size > SIZE_MAX - alignment - sizeof(Block)) return nullptr;
+  auto block = NewBlock(std::max(block_size_, size + alignment));
+  if (!block) return nullptr;
+  block->next = current_->next;
+  current_->next = block;
+  Rewind({block, 0});
+  return Bump(size, alignment);
+}
+
+BumpArena::Block *BumpArena::NewBlock(std::size_t size) {
+  auto memory = heap_->Malloc(sizeof(Block) + size);
+  return memory ? new (memory) Block{nullptr, size} : nullptr;
+}
+
+}  // namespace s21
@@ -0,0 +1,73 @@
+#ifndef MEMORY_BUMP_ARENA_H
+#define MEMORY_BUMP_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Heap.h"
+
+namespace s21 {
+// Scratch memory handed out by moving an offset through large blocks taken
+// from a heap. Allocations have no headers and are not freed one by one:
+// the arena is rewound to a mark or reset, and keeps its blocks for reuse
+// until it is destroyed.
+class BumpArena {
+ public:
+  struct Block;
+  // A position to rewind to.
+  struct Mark {
+    Block* block;
+    std::size_t offset;
+  };
+
+  constexpr static std::size_t default_block_size = 64 * 1024;
+
+  // Uses the heap of the s21::Memory functions.
+  BumpArena();
+  explicit BumpArena(Heap& heap, std::size_t block_size = default_block_size);
+  BumpArena(const BumpArena&) = delete;
+  BumpArena& operator=(const BumpArena&) = delete;
+  ~BumpArena();
+
+  // The alignment must be a power of two.
+  void* Allocate(std::size_t size,
+                 std::size_t alignment = alignof(std::max_align_t));
+  Mark GetMark() const noexcept;
+  void Rewind(Mark mark) noexcept;
+  void Reset() noexcept;
+
+ private:
+  void* Bump(std::size_t size, std::size_t alignment) noexcept;
+  void* AllocateInNextBlock(std::size_t size, std::size_t alignment);
+  Block* NewBlock(std::size_t size);
+
+  Heap* heap_;
+  std::size_t block_size_;
+  Block* first_;
+  Block* current_;
+  std::size_t offset_ = 0;
+};
+
+struct BumpArena::Block {
+  Block* next;
+  std::size_t size;
+
+  std::byte* data() noexcept { return reinterpret_cast<std::byte*>(this + 1); }
+};
+
+inline void* BumpArena::Allocate(std::size_t size, std::size_t alignment) {
+  auto ptr = Bump(size, alignment);
+  return ptr ? ptr : AllocateInNextBlock(size, alignment);
+}
+
+inline void* BumpArena::Bump(std::size_t size, std::size_t alignment) noexcept {
+  auto data = reinterpret_cast<std::uintptr_t>(current_->data());
+  auto start = ((data + offset_ + alignment - 1) & ~(alignment - 1)) - data;
+  if (start > current_->size || size > current_->size - start) return nullptr;
+  offset_ = start + size;
+  return current_->data() + start;
+}
+
+}  // namespace s21
+
+#endif  // MEMORY_BUMP_ARENA_H
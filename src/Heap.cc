@@ -1,102 +1,548 @@
 #include "Heap.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 #include <variant>
 
+#include "BuddyHeap.h"
+#include "Trace.h"
+
 namespace s21 {
 
-Heap &Heap::GetInstance(std::size_t size) {
+namespace {
+// Set while a trace is recorded. Like s21_init, it is only switched while
+// no other thread uses the API.
+std::unique_ptr<TraceWriter> recorder;
+// Serves the allocation functions instead of the heap after s21_init_buddy.
+std::unique_ptr<BuddyHeap> buddy;
+}  // namespace
+
+Heap::Header::Header(std::size_t size, Header *prev, bool last) noexcept
+    : size_state_(size), alignment_(0), type_(Type::Char), last_(last) {
+  set_prev(prev);
+}
+
+Heap::Header *Heap::Header::next() noexcept {
+  return last_ ? nullptr
+               : reinterpret_cast<Header *>(addr() + size() + alignment_);
+}
+
+const Heap::Header *Heap::Header::next() const noexcept {
+  return const_cast<Header *>(this)->next();
+}
+
+Heap::Header *Heap::Header::prev() noexcept {
+  return prev_offset_ ? reinterpret_cast<Header *>(
+                            reinterpret_cast<std::byte *>(this) -
+                            std::size_t{prev_offset_} * machine_word)
+                      : nullptr;
+}
+
+const Heap::Header *Heap::Header::prev() const noexcept {
+  return const_cast<Header *>(this)->prev();
+}
+
+std::byte *Heap::Header::addr() const noexcept {
+  return const_cast<std::byte *>(reinterpret_cast<const std::byte *>(this)) +
+         header_size;
+}
+
+std::size_t Heap::Header::size() const noexcept {
+  return size_state_ & ~tag_mask;
+}
+
+bool Heap::Header::state() const noexcept {
+  return (size_state_ & (tag_mask & ~aligned_bit & ~handle_bit)) == used_tag;
+}
+
+std::size_t Heap::Header::alignment() const noexcept { return alignment_; }
+
+Heap::Type Heap::Header::type() const noexcept { return type_; }
+
+bool Heap::Header::last() const noexcept { return last_; }
+
+bool Heap::Header::aligned() const noexcept {
+  return size_state_ & aligned_bit;
+}
+
+bool Heap::Header::zeroed() const noexcept { return size_state_ & zeroed_bit; }
+
+bool Heap::Header::handle() const noexcept { return size_state_ & handle_bit; }
+
+void Heap::Header::set_size(std::size_t size) noexcept {
+  size_state_ = (size_state_ & tag_mask) | size;
+}
+
+// A block that stays allocated keeps its alignment and handle marks. Its
+// data is no longer known to be zero.
+void Heap::Header::set_state(bool state) noexcept {
+  auto tag = state ? used_tag | (size_state_ & (aligned_bit | handle_bit)) : 0;
+  size_state_ = (size_state_ & ~tag_mask) | tag;
+}
+
+void Heap::Header::set_alignment(std::size_t alignment) noexcept {
+  alignment_ = static_cast<std::uint16_t>(alignment);
+}
+
+void Heap::Header::set_type(Type type) noexcept { type_ = type; }
+
+void Heap::Header::set_prev(const Header *prev) noexcept {
+  prev_offset_ = prev ? static_cast<std::uint32_t>(
+                            (reinterpret_cast<const std::byte *>(this) -
+                             reinterpret_cast<const std::byte *>(prev)) /
+                            machine_word)
+                      : 0;
+}
+
+void Heap::Header::set_last(bool last) noexcept { last_ = last; }
+
+void Heap::Header::set_aligned(bool aligned) noexcept {
+  size_state_ = aligned ? size_state_ | aligned_bit
+                        : size_state_ & ~aligned_bit;
+}
+
+void Heap::Header::set_zeroed(bool zeroed) noexcept {
+  size_state_ = zeroed ? size_state_ | zeroed_bit : size_state_ & ~zeroed_bit;
+}
+
+void Heap::Header::set_handle(bool handle) noexcept {
+  size_state_ = handle ? size_state_ | handle_bit : size_state_ & ~handle_bit;
+}
+
+Heap::Heap() : registry_(std::make_shared<CacheRegistry>()) {
+  registry_->heap = this;
+}
+
+Heap::~Heap() {
+  StopCompactor();
+  std::lock_guard<std::mutex> registry_lock(registry_->mutex);
+  registry_->heap = nullptr;
+  for (auto cache : registry_->caches) {
+    std::lock_guard<std::mutex> cache_lock(cache->mutex);
+    for (auto &blocks : cache->blocks) blocks.clear();
+  }
+  registry_->caches.clear();
+}
+
+Heap &Heap::GetInstance(std::size_t size, Storage storage) {
   static Heap instance;
-  instance.UpdateSize(size);
+  instance.UpdateSize(size, storage);
   if (instance.Empty()) throw std::runtime_error("heap is empty");
   return instance;
 }
 
-void Heap::UpdateSize(size_t size) {
+std::unique_ptr<Heap> Heap::Create(std::size_t size, Storage storage) {
+  std::unique_ptr<Heap> heap(new Heap);
+  heap->UpdateSize(size, storage);
+  if (heap->Empty()) throw std::runtime_error("heap is empty");
+  return heap;
+}
+
+void Heap::UpdateSize(size_t size, Storage storage) {
   if (!size) return;
   if (size < header_size + machine_word)
     throw std::runtime_error("Heap size is less than header size");
-  if (heap_) {
-    heap_.reset();
-    free_blocks_.clear();
+  if (size > max_chunk_size - 2 * header_size)
+    throw std::runtime_error("Heap size is too big");
+  auto cache_locks = LockCaches();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto cache : registry_->caches) {
+    for (auto &blocks : cache->blocks) blocks.clear();
+    cache->counters = {};
   }
+  chunks_.clear();
+  capacity_ = 0;
+  block_count_ = 0;
+  counters_ = {};
+  handles_.resize(1);
+  free_handles_.clear();
+  rover_ = nullptr;
+  compact_cursor_ = nullptr;
+  ClearFree();
+  partial_slabs_.fill(nullptr);
+  slab_set_.clear();
+  has_slabs_ = false;
+  storage_ = storage;
   size += header_size;
   size += Align(size);
-  heap_ = std::make_unique<heap_t[]>(size);
-  auto header = new (heap_.get()) Header{nullptr,
-                                         nullptr,
-                                         false,
-                                         size - header_size,
-                                         0,
-                                         heap_.get() + header_size,
-                                         Heap::Type::Char};
-  end_ = header->addr + header->size;
-  free_blocks_.push_back(header);
-}
-
-void *Heap::Malloc(std::size_t size) {
-  auto header = reinterpret_cast<Header *>(heap_.get());
-  for (auto current = header; current; current = current->next) {
-    if (!current->state && current->size >= size) {
-      auto it = std::find_if(free_blocks_.begin(), free_blocks_.end(),
-                             [&current](Header *x) { return x == current; });
-
-      if (it != free_blocks_.end()) {
-        free_blocks_.erase(it);
-      }
+  AddChunk(size);
+}
 
-      return SplitBlocks(current, size);
+template <class Counting>
+Heap::Header *Heap::AddChunk(std::size_t size) {
+  heap_t *memory;
+  if (storage_ == Storage::New) {
+    memory = new heap_t[size]();
+  } else {
+    auto mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    if (storage_ == Storage::MmapHugePages) {
+      madvise(mapping, size, MADV_HUGEPAGE);
     }
+#endif
+    memory = static_cast<heap_t *>(mapping);
   }
+  auto &chunk = chunks_.emplace_back();
+  chunk.memory = std::unique_ptr<heap_t, ChunkDeleter>(
+      memory, ChunkDeleter{size, storage_ != Storage::New});
+  chunk.end = memory + size;
+  auto header = new (memory) Header(size - header_size, nullptr, true);
+  header->set_zeroed(true);
+  capacity_ += size;
+  ++block_count_;
+  InsertFree<Counting>(header);
+  return header;
+}
 
-  return nullptr;
+// Fails for sizes no chunk can hold, before the header is added to them.
+template <class Counting>
+Heap::Header *Heap::Grow(std::size_t size) {
+  if (size > max_chunk_size) return nullptr;
+  auto needed = std::max(size, machine_word) + header_size;
+  needed += Align(needed);
+  if (capacity_ >= max_size_ || max_size_ - capacity_ < needed) return nullptr;
+  auto limit = std::min(max_size_ - capacity_, max_chunk_size);
+  if (needed > limit) return nullptr;
+  auto &last = chunks_.back();
+  // Clamped while still a double: a cast of a value past SIZE_MAX is undefined.
+  auto scaled =
+      static_cast<double>(last.end - last.memory.get()) * growth_factor_;
+  auto size_by_factor = scaled < static_cast<double>(limit)
+                            ? static_cast<std::size_t>(scaled)
+                            : limit;
+  size_by_factor -= size_by_factor % machine_word;
+  return AddChunk<Counting>(std::clamp(size_by_factor, needed, limit));
+}
+
+template <class Counting>
+bool Heap::ReleaseChunk(Header *header) {
+  auto chunk = std::find_if(chunks_.begin() + 1, chunks_.end(),
+                            [header](const Chunk &x) {
+                              return FirstHeader(x) == header;
+                            });
+  if (chunk == chunks_.end()) return false;
+  RemoveFree<Counting>(header);
+  capacity_ -= chunk->end - chunk->memory.get();
+  --block_count_;
+  chunks_.erase(chunk);
+  rover_ = nullptr;
+  compact_cursor_ = nullptr;
+  return true;
+}
+
+void Heap::ChunkDeleter::operator()(heap_t *memory) const noexcept {
+  if (mapped) {
+    munmap(memory, size);
+  } else {
+    delete[] memory;
+  }
+}
+
+std::size_t Heap::PageSize() noexcept {
+  static const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  return page_size;
+}
+
+void Heap::ReleasePages(heap_t *begin, heap_t *end) noexcept {
+  std::uintptr_t page_size = PageSize();
+  auto first = (reinterpret_cast<std::uintptr_t>(begin) + page_size - 1) &
+               ~(page_size - 1);
+  auto last = reinterpret_cast<std::uintptr_t>(end) & ~(page_size - 1);
+  if (first < last) {
+    madvise(reinterpret_cast<void *>(first), last - first, MADV_DONTNEED);
+  }
+}
+
+// Returns the pages of a free block and clears the bytes around them, so
+// that the block reads as zero past its place in the bins.
+void Heap::ReleaseBlock(Header *header) noexcept {
+  auto begin = header->addr() + machine_word;
+  auto end = header->addr() + header->size();
+  ReleasePages(begin, end);
+  auto page_size = PageSize();
+  auto offset = reinterpret_cast<std::uintptr_t>(begin) % page_size;
+  auto size = static_cast<std::size_t>(end - begin);
+  auto head = std::min(offset ? page_size - offset : 0, size);
+  auto tail = std::min(reinterpret_cast<std::uintptr_t>(end) % page_size,
+                       size - head);
+  std::memset(begin, 0, head);
+  std::memset(end - tail, 0, tail);
+  header->set_zeroed(true);
+}
+
+// Clears with streaming stores past the cache size, so that a large calloc
+// does not evict the caller's working set.
+void Heap::ClearMemory(std::byte *begin, std::size_t size) noexcept {
+#ifdef __SSE2__
+  if (size >= stream_clear_size) {
+    constexpr auto width = sizeof(__m128i);
+    auto head = (width - reinterpret_cast<std::uintptr_t>(begin) % width) %
+                width;
+    std::memset(begin, 0, head);
+    auto out = reinterpret_cast<__m128i *>(begin + head);
+    auto count = (size - head) / width;
+    auto zero = _mm_setzero_si128();
+    for (std::size_t i = 0; i < count; ++i) _mm_stream_si128(out + i, zero);
+    _mm_sfence();
+    std::memset(begin + head + count * width, 0, size - head - count * width);
+    return;
+  }
+#endif
+  std::memset(begin, 0, size);
+}
+
+Heap::Header *Heap::FirstHeader(const Chunk &chunk) noexcept {
+  return reinterpret_cast<Header *>(chunk.memory.get());
+}
+
+void Heap::SetGrowth(double factor, std::size_t max_size) {
+  if (!(factor >= 1)) {
+    throw std::invalid_argument("Growth factor is less than 1");
+  }
+  auto lock = Lock();
+  growth_factor_ = factor;
+  max_size_ = max_size;
+}
+
+std::size_t Heap::Capacity() const noexcept { return capacity_; }
+
+Heap::Stats Heap::GetStats() {
+  auto cache_locks = LockCaches();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats{};
+  stats.capacity = capacity_;
+  stats.bytes_free = free_bytes_;
+  for (std::size_t bin = 0; bin < bins_count; ++bin) {
+    stats.free_blocks_by_size[bin] = free_bins_[bin].size();
+    stats.free_blocks += free_bins_[bin].size();
+  }
+  stats.used_blocks = block_count_ - stats.free_blocks;
+  stats.bytes_in_use = capacity_ - block_count_ * header_size - free_bytes_;
+  stats.largest_free_block = LargestFree();
+  stats.external_fragmentation =
+      free_bytes_ ? 1 - static_cast<double>(stats.largest_free_block) /
+                            free_bytes_
+                  : 0;
+  auto counters = counters_;
+  for (auto cache : registry_->caches) {
+    counters.allocations += cache->counters.allocations;
+    counters.frees += cache->counters.frees;
+  }
+  stats.allocations = counters.allocations;
+  stats.frees = counters.frees;
+  stats.reallocations = counters.reallocations;
+  stats.defragmentations = counters.defragmentations;
+  return stats;
+}
+
+// Orders the top bin again if uncounted calls changed it. The other bins
+// wait until they are the top one.
+std::size_t Heap::LargestFree() noexcept {
+  if (!non_empty_bins_) return 0;
+  auto top_bin = bins_count - 1 - __builtin_clzll(non_empty_bins_);
+  auto &blocks = free_bins_[top_bin];
+  auto bin_bit = std::uint64_t{1} << top_bin;
+  if (unordered_bins_ & bin_bit) {
+    std::make_heap(blocks.begin(), blocks.end(), [](auto lhs, auto rhs) {
+      return lhs->size() < rhs->size();
+    });
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+      FreeIndex(blocks[i]) = static_cast<std::uint32_t>(i);
+    }
+    unordered_bins_ &= ~bin_bit;
+  }
+  return blocks.front()->size();
 }
 
+void *Heap::Malloc(std::size_t size) { return Allocate(size); }
+
 void *Heap::MallocOnlyFree(std::size_t size) {
-  for (auto it = free_blocks_.begin(); it != free_blocks_.end(); ++it) {
-    if ((*it)->size >= size) {
-      auto header = *it;
-      free_blocks_.erase(it);
-      auto addr = SplitBlocks(header, size);
-      return addr;
+  return Allocate<policy::SegregatedFit>(size);
+}
+
+// The block is carved from a free block big enough to hold the size at any
+// alignment, and the space in front of the aligned address is freed again.
+void *Heap::AlignedMalloc(std::size_t alignment, std::size_t size) {
+  if (!alignment || alignment & (alignment - 1)) {
+    throw std::invalid_argument("Alignment is not a power of two");
+  }
+  if (alignment <= min_alignment_) return Malloc(size);
+  std::size_t reserved;
+  if (__builtin_add_overflow(alignment, header_size + machine_word,
+                             &reserved) ||
+      __builtin_add_overflow(size, reserved, &reserved)) {
+    return nullptr;
+  }
+  auto lock = Lock();
+  auto header = TakeFreeOrGrow(reserved);
+  if (!header) header = TakeAligned(alignment, size);
+  if (!header) return nullptr;
+  header = AlignBlock(header, alignment);
+  auto ptr = SplitBlocks(header, size);
+  header->set_aligned(true);
+  return CountAllocation(ptr);
+}
+
+// Blocks are carved one after another from a free region that holds all of
+// them, or from as few regions as the free blocks allow. Batches bypass
+// slabs and thread caches.
+std::size_t Heap::MallocBatch(std::size_t size, std::size_t count,
+                              void **out) {
+  std::size_t footprint = 0;
+  if (__builtin_add_overflow(size, header_size + BlockAlignment(size),
+                             &footprint) ||
+      footprint > max_chunk_size) {
+    return 0;
+  }
+  auto lock = Lock();
+  std::size_t done = 0;
+  while (done < count) {
+    auto left = count - done;
+    // Only a run whose footprint fits in one chunk is taken at once.
+    auto header = left <= max_chunk_size / footprint
+                      ? TakeFreeOrGrow(left * footprint - header_size)
+                      : nullptr;
+    if (!header) header = TakeFreeOrGrow(size);
+    if (!header) break;
+    done += CarveBlocks(header, size, left, out + done);
+  }
+  counters_.allocations += done;
+  return done;
+}
+
+template <class Counting>
+Heap::Header *Heap::TakeFirstFit(std::size_t size) {
+  for (auto &chunk : chunks_) {
+    for (auto current = FirstHeader(chunk); current;
+         current = current->next()) {
+      if (!current->state() && current->size() >= size) {
+        RemoveFree<Counting>(current);
+        return current;
+      }
     }
   }
+  auto header = Grow<Counting>(size);
+  if (!header || header->size() < size) return nullptr;
+  RemoveFree<Counting>(header);
 
-  return nullptr;
+  return header;
+}
+
+// Searches on from the block where the last search ended and wraps around
+// to it, so the allocated blocks at the front are not walked on every call.
+template <class Counting>
+Heap::Header *Heap::TakeNextFit(std::size_t size) {
+  if (!rover_) {
+    rover_ = FirstHeader(chunks_.front());
+    rover_chunk_ = 0;
+  }
+  auto start = rover_;
+  auto start_chunk = rover_chunk_;
+  for (std::size_t i = 0; i <= chunks_.size(); ++i) {
+    auto chunk = (start_chunk + i) % chunks_.size();
+    auto current = i ? FirstHeader(chunks_[chunk]) : start;
+    for (; current; current = current->next()) {
+      if (i && current == start) break;
+      if (!current->state() && current->size() >= size) {
+        RemoveFree<Counting>(current);
+        rover_ = current;
+        rover_chunk_ = chunk;
+        return current;
+      }
+    }
+  }
+  auto header = Grow<Counting>(size);
+  if (!header || header->size() < size) return nullptr;
+  RemoveFree<Counting>(header);
+  rover_ = header;
+  rover_chunk_ = chunks_.size() - 1;
+
+  return header;
+}
+
+// The smallest free block that holds the size, the lowest of them if there
+// are several, which keeps large blocks whole for large requests.
+template <class Counting>
+Heap::Header *Heap::TakeBestFit(std::size_t size) {
+  auto block = free_tree_.lower_bound({size, nullptr});
+  Header *header = nullptr;
+  if (block != free_tree_.end()) {
+    header = block->second;
+  } else {
+    header = Grow<Counting>(size);
+    if (header && header->size() < size) header = nullptr;
+  }
+  if (header) RemoveFree<Counting>(header);
+
+  return header;
 }
 
+template <class Counting>
 void *Heap::SplitBlocks(Header *header,
                         size_t new_current_block_size) noexcept {
-  if (header->size != new_current_block_size) {
-    auto end = header->addr + header->size + header->alignment;
-    auto new_current_block_alignment =
-        Align(new_current_block_size + header_size);
-
-    header->size = new_current_block_size;
-    header->alignment = new_current_block_alignment;
-    auto new_header_byte = header->addr + header->size + header->alignment;
+  if (header->size() != new_current_block_size) {
+    auto end = header->addr() + header->size() + header->alignment();
+    auto new_current_block_alignment = BlockAlignment(new_current_block_size);
+
+    header->set_size(new_current_block_size);
+    header->set_alignment(new_current_block_alignment);
+    auto new_header_byte =
+        header->addr() + header->size() + header->alignment();
     auto space_left = end - new_header_byte;
     if (space_left < static_cast<long>(header_size + machine_word)) {
-      header->alignment += space_left;
+      header->set_alignment(header->alignment() + space_left);
     } else {
-      auto new_header =
-          new (new_header_byte) Header{header->next,
-                                       header,
-                                       false,
-                                       space_left - header_size,
-                                       0,
-                                       new_header_byte + header_size,
-                                       Heap::Type::Char};
-      if (header->next) header->next->prev = new_header;
-      header->next = new_header;
-      free_blocks_.push_back(new_header);
+      auto new_header = new (new_header_byte)
+          Header(space_left - header_size, header, header->last());
+      new_header->set_zeroed(header->zeroed());
+      if (new_header->next()) new_header->next()->set_prev(new_header);
+      header->set_last(false);
+      ++block_count_;
+      InsertFree<Counting>(new_header);
     }
   }
-  header->state = true;
+  header->set_state(true);
 
-  return static_cast<void *>(header->addr);
+  return static_cast<void *>(header->addr());
+}
+
+// Splits up to count blocks of the size off a free block taken from the
+// bins and returns how many were split off.
+std::size_t Heap::CarveBlocks(Header *header, std::size_t size,
+                              std::size_t count, void **out) noexcept {
+  auto alignment = BlockAlignment(size);
+  auto footprint = header_size + size + alignment;
+  for (std::size_t carved = 1;; ++carved) {
+    *out++ = header->addr();
+    auto end = header->addr() + header->size();
+    auto next_byte = header->addr() + size + alignment;
+    if (carved == count ||
+        static_cast<std::size_t>(end - next_byte) < footprint) {
+      SplitBlocks(header, size);
+      if (auto next = header->next()) next->set_prev(header);
+      return carved;
+    }
+    auto next = new (next_byte)
+        Header(end - next_byte - header_size, header, header->last());
+    header->set_size(size);
+    header->set_alignment(alignment);
+    header->set_last(false);
+    header->set_state(true);
+    ++block_count_;
+    header = next;
+  }
 }
 
 std::size_t Heap::Align(std::size_t size) noexcept {
@@ -104,163 +550,937 @@ std::size_t Heap::Align(std::size_t size) noexcept {
   return (size / machine_word + 1) * machine_word - size;
 }
 
-void *Heap::Calloc(std::size_t num, std::size_t size) {
-  auto total_size = num * size;
-  auto mem = Malloc(total_size);
-  if (mem) {
-    std::fill_n(reinterpret_cast<std::byte *>(mem), total_size, std::byte(0));
+// Pads a block so that the data after the next header is on the minimum
+// alignment. An empty block still gets a word for its place in the bins.
+std::size_t Heap::BlockAlignment(std::size_t size) const noexcept {
+  auto footprint = std::max(size, machine_word) + header_size;
+  auto padded = (footprint + min_alignment_ - 1) & ~(min_alignment_ - 1);
+  return padded - header_size - size;
+}
+
+std::uint32_t &Heap::FreeIndex(Header *header) noexcept {
+  return *reinterpret_cast<std::uint32_t *>(header->addr());
+}
+
+std::size_t Heap::BinIndex(std::size_t size) noexcept {
+  return size ? bins_count - 1 - __builtin_clzll(size) : 0;
+}
+
+// The free bytes are counted in both modes, as a single addition is all
+// GetStats needs to stay in constant time.
+template <class Counting>
+void Heap::InsertFree(Header *header) {
+  auto bin = BinIndex(header->size());
+  auto &blocks = free_bins_[bin];
+  blocks.push_back(header);
+  if constexpr (std::is_same_v<Counting, policy::Counted>) {
+    SiftBin(blocks, blocks.size() - 1);
+  } else {
+    FreeIndex(header) = static_cast<std::uint32_t>(blocks.size() - 1);
+    unordered_bins_ |= std::uint64_t{1} << bin;
   }
-  return mem;
+  non_empty_bins_ |= std::uint64_t{1} << bin;
+  free_bytes_ += header->size();
+  if (tree_kept_) free_tree_.emplace(header->size(), header);
 }
 
-void *Heap::CallocOnlyFree(std::size_t num, std::size_t size) {
-  auto total_size = num * size;
-  auto addr = MallocOnlyFree(total_size);
+template <class Counting>
+void Heap::RemoveFree(Header *header) {
+  auto bin = BinIndex(header->size());
+  auto &blocks = free_bins_[bin];
+  auto last = blocks.back();
+  auto index = FreeIndex(header);
+  blocks.pop_back();
+  if (last != header) {
+    blocks[index] = last;
+    if constexpr (std::is_same_v<Counting, policy::Counted>) {
+      SiftBin(blocks, index);
+    } else {
+      FreeIndex(last) = static_cast<std::uint32_t>(index);
+      unordered_bins_ |= std::uint64_t{1} << bin;
+    }
+  }
+  if (blocks.empty()) {
+    non_empty_bins_ &= ~(std::uint64_t{1} << bin);
+    unordered_bins_ &= ~(std::uint64_t{1} << bin);
+  }
+  free_bytes_ -= header->size();
+  if (tree_kept_) free_tree_.erase({header->size(), header});
+}
+
+// Moves the block at the index up or down the bin until the bin is a binary
+// max-heap by size again, so that the largest block of a bin is its first.
+// The last block of a bin is a leaf and is taken without moving any other.
+void Heap::SiftBin(std::vector<Header *> &blocks, std::size_t index) noexcept {
+  auto block = blocks[index];
+  auto size = block->size();
+  while (index && blocks[(index - 1) / 2]->size() < size) {
+    blocks[index] = blocks[(index - 1) / 2];
+    FreeIndex(blocks[index]) = static_cast<std::uint32_t>(index);
+    index = (index - 1) / 2;
+  }
+  for (auto child = 2 * index + 1; child < blocks.size();
+       child = 2 * index + 1) {
+    if (child + 1 < blocks.size() &&
+        blocks[child + 1]->size() > blocks[child]->size()) {
+      ++child;
+    }
+    if (blocks[child]->size() <= size) break;
+    blocks[index] = blocks[child];
+    FreeIndex(blocks[index]) = static_cast<std::uint32_t>(index);
+    index = child;
+  }
+  blocks[index] = block;
+  FreeIndex(block) = static_cast<std::uint32_t>(index);
+}
 
-  if (addr) {
-    std::fill_n(reinterpret_cast<std::byte *>(addr), total_size, std::byte(0));
+template <class Counting>
+Heap::Header *Heap::TakeFree(std::size_t size) {
+  // Every block of a bin starting at or above the size is big enough, so the
+  // lowest such non-empty bin is served without a search. Only when all of
+  // them are empty the size's own bin is scanned for a fitting block.
+  auto fitting_bin = size > 1 ? BinIndex(size - 1) + 1 : 0;
+  auto larger = fitting_bin < bins_count ? non_empty_bins_ >> fitting_bin : 0;
+  Header *header = nullptr;
+  if (larger) {
+    header = free_bins_[fitting_bin + __builtin_ctzll(larger)].back();
+  } else {
+    for (auto block : free_bins_[BinIndex(size)]) {
+      if (block->size() >= size) {
+        header = block;
+        break;
+      }
+    }
   }
+  if (header) RemoveFree<Counting>(header);
+
+  return header;
+}
+
+template <class Counting>
+Heap::Header *Heap::TakeFreeOrGrow(std::size_t size) {
+  auto header = TakeFree<Counting>(size);
+  if (!header && Grow<Counting>(size)) header = TakeFree<Counting>(size);
+  return header;
+}
+
+void Heap::ClearFree() noexcept {
+  for (auto &blocks : free_bins_) blocks.clear();
+  non_empty_bins_ = 0;
+  unordered_bins_ = 0;
+  free_tree_.clear();
+  free_bytes_ = 0;
+}
 
-  return addr;
+void *Heap::CountAllocation(void *ptr) noexcept {
+  if (ptr) ++counters_.allocations;
+  return ptr;
 }
 
-void Heap::Free(void *ptr) {
+void *Heap::Calloc(std::size_t num, std::size_t size) {
+  return AllocateZeroed(num, size);
+}
+
+void *Heap::CallocOnlyFree(std::size_t num, std::size_t size) {
+  return AllocateZeroed<policy::SegregatedFit>(num, size);
+}
+
+template <class Counting>
+void *Heap::ClearBlock(Header *header, std::size_t size) noexcept {
+  if (!header) return nullptr;
+  auto zeroed = header->zeroed();
+  auto ptr = static_cast<std::byte *>(SplitBlocks<Counting>(header, size));
+  ClearMemory(ptr, zeroed ? std::min(size, machine_word) : size);
+  return ptr;
+}
+
+void Heap::Free(void *ptr) { Deallocate(ptr); }
+
+// A block bigger than any slot is not a slot, so the size spares the slab
+// lookup and the lock it needs.
+void Heap::Free(void *ptr, std::size_t size) {
+  if (size <= slab_max_size) return Free(ptr);
+  FreeHeader(FindPointer(ptr));
+}
+
+std::size_t Heap::UsableSize(void *ptr) {
+  if (has_slabs_) {
+    auto lock = Lock();
+    if (auto slab = FindSlab(ptr)) return slab->slot_size;
+  }
   auto header = FindPointer(ptr);
-  if (header) {
-    header->state = false;
-    header->size += header->alignment;
-    header->alignment = 0;
-    free_blocks_.push_back(header);
+  return header ? header->size() + header->alignment() : 0;
+}
+
+// Neighbouring blocks of the batch are joined before they are freed, so a
+// run of them goes back to the bins as one block.
+// Every pointer is checked before anything is freed, so a rejected batch
+// leaves the heap as it was.
+void Heap::FreeBatch(void *const *ptrs, std::size_t count) {
+  std::vector<Header *> headers;
+  std::vector<std::pair<void *, Slab *>> slots;
+  headers.reserve(count);
+  auto lock = Lock();
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!ptrs[i]) continue;
+    if (has_slabs_) {
+      if (auto slab = FindSlab(ptrs[i])) {
+        slots.emplace_back(ptrs[i], slab);
+        continue;
+      }
+    }
+    headers.push_back(FindPointer(ptrs[i]));
+  }
+  std::sort(headers.begin(), headers.end());
+  std::sort(slots.begin(), slots.end());
+  auto same_slot = [](const auto &lhs, const auto &rhs) {
+    return lhs.first == rhs.first;
+  };
+  if (std::adjacent_find(headers.begin(), headers.end()) != headers.end() ||
+      std::adjacent_find(slots.begin(), slots.end(), same_slot) !=
+          slots.end()) {
+    throw std::runtime_error("wrong pointer");
+  }
+  for (auto [ptr, slab] : slots) SlabFree(*slab, ptr);
+  counters_.frees += slots.size() + headers.size();
+  for (std::size_t i = 0; i < headers.size();) {
+    auto first = headers[i++];
+    while (i < headers.size() && first->next() == headers[i]) {
+      AbsorbNext(first);
+      ++i;
+    }
+    FreeBlock(first);
+  }
+}
+
+void Heap::FreeHeader(Header *header) {
+  if (!header) return;
+  // Aligned blocks stay where they are, so they are not handed out again by
+  // a cache as ordinary blocks.
+  auto footprint = header->size() + header->alignment();
+  if (!header->aligned() && concurrent_ && footprint &&
+      footprint <= cache_max_size) {
+    CachedFree(header);
+  } else {
+    auto lock = Lock();
+    ++counters_.frees;
+    FreeBlock(header);
+  }
+}
+
+template <class Counting>
+void Heap::FreeBlock(Header *header) {
+  auto freed_begin = header->addr() - header_size;
+  auto freed_end = header->addr() + header->size() + header->alignment();
+  header->set_state(false);
+  header->set_size(header->size() + header->alignment());
+  header->set_alignment(0);
+  if (coalescing_) {
+    // A neighbour below the threshold kept its pages when it was freed, so
+    // they are returned along with the freed block.
+    if (header->prev() && !header->prev()->state()) {
+      if (header->prev()->size() < release_threshold) {
+        freed_begin = header->prev()->addr();
+      }
+      header = header->prev();
+      RemoveFree<Counting>(header);
+      AbsorbNext(header);
+    }
+    auto next = header->next();
+    if (next && !next->state() && next->size() < release_threshold) {
+      freed_end = next->addr() + next->size();
+    }
+    MergeBlocks<Counting>(header);
+  }
+  InsertFree<Counting>(header);
+  if (!header->prev() && header->last() && ReleaseChunk<Counting>(header)) {
+    return;
+  }
+  if (storage_ != Storage::New && header->size() >= release_threshold) {
+    // Neighbours of at least the threshold were returned when they were
+    // freed, so only the pages around the rest are. The first word of the
+    // block holds its place in the bins and is kept.
+    auto data = header->addr() + machine_word;
+    auto begin = std::max(data, freed_begin - PageSize());
+    auto end =
+        std::min(header->addr() + header->size(), freed_end + PageSize());
+    ReleasePages(begin, end);
+  }
+}
+
+void Heap::SetCoalescing(bool coalescing) noexcept { coalescing_ = coalescing; }
+
+// The tree is only kept while it is used, so that other placements pay
+// nothing for it.
+void Heap::SetPlacement(Placement placement) {
+  auto lock = Lock();
+  placement_ = placement;
+  if (placement == Placement::BestFit) {
+    if (!tree_kept_) KeepTree();
+  } else {
+    tree_kept_ = false;
+    free_tree_.clear();
+  }
+}
+
+void Heap::SetBestFit(bool best_fit) {
+  SetPlacement(best_fit ? Placement::BestFit : Placement::FirstFit);
+}
+
+void Heap::KeepTree() {
+  tree_kept_ = true;
+  for (const auto &blocks : free_bins_) {
+    for (auto block : blocks) free_tree_.emplace(block->size(), block);
   }
 }
 
 void *Heap::Realloc(void *ptr, std::size_t size) {
-  auto header = FindPointer(ptr);
-  return (header == nullptr) ? Malloc(size) : ExpOrMoveBlock(header, size);
+  return Reallocate(ptr, size);
 }
 
 void *Heap::ReallocOnlyFree(void *ptr, std::size_t size) {
-  auto header = FindPointer(ptr);
-  return (header == nullptr) ? MallocOnlyFree(size)
-                             : ExpOrMoveBlock(header, size);
+  return Reallocate<policy::SegregatedFit>(ptr, size);
+}
+
+void Heap::SetConcurrent(bool concurrent) {
+  if (!concurrent) {
+    auto cache_locks = LockCaches();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto cache : registry_->caches) ReturnCachedBlocks(*cache);
+  }
+  concurrent_ = concurrent;
+}
+
+std::unique_lock<std::mutex> Heap::Lock() {
+  return concurrent_ || compacting_ ? std::unique_lock<std::mutex>(mutex_)
+                                    : std::unique_lock<std::mutex>();
+}
+
+std::vector<std::unique_lock<std::mutex>> Heap::LockCaches() {
+  std::vector<std::unique_lock<std::mutex>> locks;
+  locks.emplace_back(registry_->mutex);
+  for (auto cache : registry_->caches) locks.emplace_back(cache->mutex);
+  return locks;
+}
+
+Heap::ThreadCache::ThreadCache(std::shared_ptr<CacheRegistry> registry)
+    : registry(std::move(registry)) {
+  std::lock_guard<std::mutex> registry_lock(this->registry->mutex);
+  this->registry->caches.push_back(this);
+}
+
+Heap::ThreadCache::~ThreadCache() {
+  std::lock_guard<std::mutex> registry_lock(registry->mutex);
+  auto heap = registry->heap;
+  if (!heap) return;
+  {
+    std::lock_guard<std::mutex> cache_lock(mutex);
+    std::lock_guard<std::mutex> lock(heap->mutex_);
+    heap->ReturnCachedBlocks(*this);
+  }
+  auto &caches = registry->caches;
+  caches.erase(std::find(caches.begin(), caches.end(), this));
+}
+
+Heap::ThreadCache &Heap::LocalCache() {
+  thread_local std::vector<std::unique_ptr<ThreadCache>> caches;
+  for (auto &cache : caches) {
+    if (cache->registry == registry_) return *cache;
+  }
+  caches.erase(std::remove_if(caches.begin(), caches.end(),
+                              [](const std::unique_ptr<ThreadCache> &cache) {
+                                std::lock_guard<std::mutex> registry_lock(
+                                    cache->registry->mutex);
+                                return cache->registry->heap == nullptr;
+                              }),
+               caches.end());
+  caches.push_back(std::make_unique<ThreadCache>(registry_));
+  return *caches.back();
+}
+
+void *Heap::CachedMalloc(std::size_t size) {
+  auto &cache = LocalCache();
+  std::lock_guard<std::mutex> cache_lock(cache.mutex);
+  auto cache_class = (size + machine_word - 1) / machine_word;
+  auto &blocks = cache.blocks[cache_class];
+  if (blocks.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto i = cache_batch; i; --i) {
+      auto header = i == cache_batch
+                        ? TakeFreeOrGrow(cache_class * machine_word)
+                        : TakeFree(cache_class * machine_word);
+      if (!header) break;
+      SplitBlocks(header, cache_class * machine_word);
+      blocks.push_back(header);
+    }
+    if (blocks.empty()) return nullptr;
+  }
+  // The block keeps the size of its class: other threads walking the heap
+  // under the heap lock derive the next block from its size and alignment,
+  // so they must not change here without that lock.
+  auto header = blocks.back();
+  blocks.pop_back();
+  ++cache.counters.allocations;
+
+  return static_cast<void *>(header->addr());
+}
+
+void Heap::CachedFree(Header *header) {
+  auto &cache = LocalCache();
+  std::lock_guard<std::mutex> cache_lock(cache.mutex);
+  auto &blocks =
+      cache.blocks[(header->size() + header->alignment()) / machine_word];
+  blocks.push_back(header);
+  ++cache.counters.frees;
+  if (blocks.size() > 2 * cache_batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto i = cache_batch; i; --i) {
+      FreeBlock(blocks.back());
+      blocks.pop_back();
+    }
+  }
+}
+
+void Heap::ReturnCachedBlocks(ThreadCache &cache) {
+  for (auto &blocks : cache.blocks) {
+    for (auto header : blocks) FreeBlock(header);
+    blocks.clear();
+  }
+  counters_.allocations += cache.counters.allocations;
+  counters_.frees += cache.counters.frees;
+  cache.counters = {};
+}
+
+// Blocks already carved keep their places, so only a heap without
+// allocated blocks can change it.
+void Heap::SetMinAlignment(std::size_t alignment) {
+  if (alignment != machine_word && alignment != 2 * machine_word) {
+    throw std::invalid_argument("Minimum alignment is not 8 or 16 bytes");
+  }
+  auto lock = Lock();
+  std::size_t free_blocks = 0;
+  for (auto &blocks : free_bins_) free_blocks += blocks.size();
+  if (block_count_ != free_blocks) {
+    throw std::runtime_error("Heap has allocated blocks");
+  }
+  min_alignment_ = alignment;
+}
+
+void Heap::SetSlabs(bool slabs) {
+  auto lock = Lock();
+  slabs_ = slabs;
+  if (!slabs) ReleaseEmptySlabs();
+}
+
+Heap::Slab *Heap::NewSlab(std::size_t slot_size) {
+  auto header = TakeFreeOrGrow(2 * slab_size + header_size + machine_word);
+  if (!header) return nullptr;
+  // The slab leaves room for the header of the next block before the next
+  // aligned address, so slabs carved one after another are back to back.
+  header = AlignBlock(header, slab_size);
+  SplitBlocks(header, slab_size - header_size);
+  auto slab = new (header->addr()) Slab{};
+  slab->slot_size = static_cast<std::uint32_t>(slot_size);
+  slab->capacity = static_cast<std::uint32_t>(
+      (slab_size - header_size - sizeof(Slab)) / slot_size);
+  slab_set_.insert(header->addr());
+  has_slabs_ = true;
+  return slab;
+}
+
+void *Heap::SlabMalloc(std::size_t size) {
+  auto slab_class = (size - 1) / machine_word;
+  auto &list = partial_slabs_[slab_class];
+  if (!list) {
+    auto slab = NewSlab((slab_class + 1) * machine_word);
+    if (!slab) return nullptr;
+    LinkSlab(list, *slab);
+  }
+  auto &slab = *list;
+  void *slot = slab.free_slots;
+  if (slot) {
+    slab.free_slots = *static_cast<void **>(slot);
+  } else {
+    slot = reinterpret_cast<std::byte *>(&slab + 1) +
+           std::size_t{slab.untouched++} * slab.slot_size;
+  }
+  if (++slab.used == slab.capacity) UnlinkSlab(list, slab);
+  return slot;
+}
+
+void Heap::SlabFree(Slab &slab, void *ptr) {
+  auto &list = partial_slabs_[slab.slot_size / machine_word - 1];
+  *static_cast<void **>(ptr) = slab.free_slots;
+  slab.free_slots = ptr;
+  if (slab.used-- == slab.capacity) LinkSlab(list, slab);
+  // One empty slab per class is kept to avoid carving it again right away.
+  if (!slab.used && (!slabs_ || list != &slab || slab.next)) ReleaseSlab(slab);
+}
+
+Heap::Slab *Heap::FindSlab(const void *ptr) const {
+  auto base = reinterpret_cast<std::uintptr_t>(ptr) & ~(slab_size - 1);
+  auto slab = reinterpret_cast<heap_t *>(base);
+  return slab_set_.count(slab) ? reinterpret_cast<Slab *>(slab) : nullptr;
+}
+
+void Heap::LinkSlab(Slab *&list, Slab &slab) noexcept {
+  slab.prev = nullptr;
+  slab.next = list;
+  if (list) list->prev = &slab;
+  list = &slab;
+}
+
+void Heap::UnlinkSlab(Slab *&list, Slab &slab) noexcept {
+  if (slab.prev) {
+    slab.prev->next = slab.next;
+  } else {
+    list = slab.next;
+  }
+  if (slab.next) slab.next->prev = slab.prev;
+  slab.prev = slab.next = nullptr;
+}
+
+void Heap::ReleaseSlab(Slab &slab) {
+  UnlinkSlab(partial_slabs_[slab.slot_size / machine_word - 1], slab);
+  auto memory = reinterpret_cast<heap_t *>(&slab);
+  slab_set_.erase(memory);
+  has_slabs_ = !slab_set_.empty();
+  FreeBlock(reinterpret_cast<Header *>(memory - header_size));
+}
+
+void Heap::ReleaseEmptySlabs() {
+  for (auto list : partial_slabs_) {
+    for (Slab *slab = list, *next; slab; slab = next) {
+      next = slab->next;
+      if (!slab->used) ReleaseSlab(*slab);
+    }
+  }
+}
+
+Heap::Header *Heap::AlignBlock(Header *header, std::size_t alignment) {
+  auto address = reinterpret_cast<std::uintptr_t>(header->addr());
+  auto aligned = AlignedAddress(address, alignment);
+  if (aligned == address) return header;
+  auto end = header->addr() + header->size() + header->alignment();
+  auto aligned_addr = header->addr() + (aligned - address);
+  auto aligned_header = new (aligned_addr - header_size)
+      Header(end - aligned_addr, header, header->last());
+  aligned_header->set_zeroed(header->zeroed());
+  if (aligned_header->next()) aligned_header->next()->set_prev(aligned_header);
+  header->set_size(aligned - address - header_size);
+  header->set_alignment(0);
+  header->set_last(false);
+  ++block_count_;
+  InsertFree(header);
+  return aligned_header;
+}
+
+std::uintptr_t Heap::AlignedAddress(std::uintptr_t address,
+                                    std::size_t alignment) noexcept {
+  if (!(address & (alignment - 1))) return address;
+  // The space in front of the aligned address has to hold a free block of
+  // its own, so the address is moved past the smallest such block.
+  return (address + header_size + machine_word + alignment - 1) &
+         ~(alignment - 1);
+}
+
+// Looks through the free blocks for one that holds the size at the given
+// alignment, for when none is big enough to hold it at any alignment. The
+// size is padded as SplitBlocks pads it, so that even an empty block keeps
+// a word in front of the next header.
+Heap::Header *Heap::TakeAligned(std::size_t alignment, std::size_t size) {
+  auto footprint = size + BlockAlignment(size);
+  for (auto bin = BinIndex(size); bin < bins_count; ++bin) {
+    for (auto block : free_bins_[bin]) {
+      auto address = reinterpret_cast<std::uintptr_t>(block->addr());
+      if (AlignedAddress(address, alignment) - address + footprint <=
+          block->size()) {
+        RemoveFree(block);
+        return block;
+      }
+    }
+  }
+  return nullptr;
 }
 
 Heap::Header *Heap::FindPointer(void *ptr) {
   if (!ptr) return nullptr;
   auto current =
       reinterpret_cast<Header *>(static_cast<std::byte *>(ptr) - header_size);
-  if (!current->state) throw std::runtime_error("wrong pointer");
+  if (!current->state()) throw std::runtime_error("wrong pointer");
   return current;
 }
 
-void *Heap::ExpOrMoveBlock(Heap::Header *header, size_t size) {
-  while (size > header->size && MergeBlocks(header))
-    ;
+// Grows into the free blocks around the block when they hold the size, so
+// the data is copied only when it moves back into a free previous block.
+// Space given up by shrinking joins a free next block. Returns null when
+// the block has to move elsewhere.
+template <class Counting>
+void *Heap::ResizeBlock(Heap::Header *header, std::size_t size) {
+  auto footprint = header->size() + header->alignment();
+  auto space = footprint;
+  for (auto next = header->next(); next && !next->state() && space < size;
+       next = next->next()) {
+    space += header_size + next->size();
+  }
+  if (size <= space) {
+    while (size > header->size() + header->alignment() &&
+           MergeBlocks<Counting>(header))
+      ;
+    if (size < footprint && coalescing_) MergeBlocks<Counting>(header);
+    return SplitBlocks<Counting>(header, size);
+  }
 
-  if (size <= header->size) {
-    return SplitBlocks(header, size);
-  } else {
-    auto new_ptr = MallocOnlyFree(size);
-    if (new_ptr) {
-      std::copy_n(header->addr, header->size,
-                  static_cast<std::byte *>(new_ptr));
-      header->state = false;
-      free_blocks_.push_back(header);
-    }
-    return new_ptr;
+  // An aligned block would lose its alignment by moving back.
+  auto prev = header->prev();
+  if (prev && !prev->state() && !header->aligned() &&
+      size <= header_size + prev->size() + space) {
+    auto data = header->addr();
+    while (MergeBlocks<Counting>(header))
+      ;
+    RemoveFree<Counting>(prev);
+    AbsorbNext(prev);
+    std::memmove(prev->addr(), data, footprint);
+    return SplitBlocks<Counting>(prev, size);
   }
+
+  return nullptr;
 }
 
+template <class Counting>
 bool Heap::MergeBlocks(Heap::Header *header) {
-  if (header->next && !header->next->state) {
-    auto it = std::find_if(free_blocks_.begin(), free_blocks_.end(),
-                           [&header](Header *x) { return x == header->next; });
-
-    if (it != free_blocks_.end()) {
-      free_blocks_.erase(it);
-    }
-
-    header->size += header->alignment + header->next->size +
-                    header->next->alignment + header_size;
-    header->alignment = 0;
-    header->next = header->next->next;
-    if (header->next) header->next->prev = header;
+  if (header->next() && !header->next()->state()) {
+    RemoveFree<Counting>(header->next());
+    AbsorbNext(header);
     return true;
   }
 
   return false;
 }
 
-void Heap::Defragmentation() {
+// Two zeroed blocks make a zeroed block once the header between them and
+// the first word after it are cleared.
+void Heap::AbsorbNext(Heap::Header *header) noexcept {
+  auto next = header->next();
+  auto zeroed = header->zeroed() && next->zeroed();
+  header->set_size(header->size() + header->alignment() + header_size +
+                   next->size() + next->alignment());
+  header->set_alignment(0);
+  header->set_last(next->last());
+  if (header->next()) header->next()->set_prev(header);
+  --block_count_;
+  if (rover_ == next) rover_ = header;
+  if (compact_cursor_ == next) compact_cursor_ = header;
+  if (zeroed) {
+    std::memset(static_cast<void *>(next), 0, header_size + machine_word);
+  } else {
+    header->set_zeroed(false);
+  }
+}
+
+void Heap::Defragmentation() { Defragmentation(nullptr); }
+
+void Heap::Defragmentation(
+    const std::function<void(void *, void *)> &moved) {
+  auto cache_locks = LockCaches();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto cache : registry_->caches) ReturnCachedBlocks(*cache);
+  ++counters_.defragmentations;
+  ReleaseEmptySlabs();
+  ClearFree();
+  rover_ = nullptr;
+  compact_cursor_ = nullptr;
+  for (auto &chunk : chunks_) DefragmentChunk(chunk, moved);
+  for (auto chunk = chunks_.size() - 1; chunk; --chunk) {
+    auto header = FirstHeader(chunks_[chunk]);
+    if (!header->state() && header->last()) ReleaseChunk(header);
+  }
+}
+
+void Heap::DefragmentChunk(
+    Chunk &chunk, const std::function<void(void *, void *)> &moved) {
   Header *previous = nullptr;
   size_t memory_shift = 0;
 
-  for (auto current = reinterpret_cast<Header *>(heap_.get()); current;
-       current = current->next) {
-    if (current->state) {
+  for (Header *current = FirstHeader(chunk), *next; current; current = next) {
+    next = current->next();
+    if (current->state() && (current->aligned() || Pinned(current) ||
+                             slab_set_.count(current->addr()))) {
+      // Slots are found by their address, pinned blocks are being read and
+      // aligned blocks would lose their alignment, so they stay in place
+      // and the space gathered in front of them becomes a free block.
+      auto slab_begin = reinterpret_cast<heap_t *>(current);
+      if (memory_shift) previous = FillGap(chunk, previous, slab_begin);
+      current->set_prev(previous);
+      previous = current;
+      memory_shift = 0;
+    } else if (current->state()) {
       std::size_t extra_memory_of_current_block = 0;
-      if (current->alignment > machine_word) {
+      if (current->alignment() > machine_word) {
         extra_memory_of_current_block =
-            current->alignment - Align(current->size + header_size);
-        current->alignment -= extra_memory_of_current_block;
+            current->alignment() - BlockAlignment(current->size());
+        current->set_alignment(current->alignment() -
+                               extra_memory_of_current_block);
       }
-      auto byte_ptr = current->addr - header_size;
-      std::copy_n(byte_ptr, header_size + current->size + current->alignment,
+      auto handle = HandleOf(current);
+      auto byte_ptr = reinterpret_cast<std::byte *>(current);
+      std::copy_n(byte_ptr,
+                  header_size + current->size() + current->alignment(),
                   byte_ptr - memory_shift);
       current = reinterpret_cast<Header *>(byte_ptr - memory_shift);
-      current->addr = byte_ptr - memory_shift + header_size;
-      current->prev = previous;
-      if (previous) previous->next = current;
+      current->set_prev(previous);
+      if (handle) handles_[handle].data = current->addr() + machine_word;
+      if (moved && memory_shift) moved(byte_ptr + header_size, current->addr());
       previous = current;
       memory_shift += extra_memory_of_current_block;
     } else {
-      memory_shift += header_size + current->size;
+      memory_shift += header_size + current->size();
+      --block_count_;
     }
   }
-  free_blocks_.clear();
-  if (previous && memory_shift) {
-    auto start_of_free_space =
-        previous->addr + previous->size + previous->alignment;
-    size_t size_of_free_space = end_ - start_of_free_space;
-    if (size_of_free_space < header_size + machine_word) {
-      previous->alignment += size_of_free_space;
+  if (memory_shift) FillGap(chunk, previous, chunk.end);
+}
+
+Heap::Header *Heap::FillGap(const Chunk &chunk, Header *previous,
+                            heap_t *end) {
+  auto start_of_free_space =
+      previous ? previous->addr() + previous->size() + previous->alignment()
+               : chunk.memory.get();
+  size_t size_of_free_space = end - start_of_free_space;
+  auto last = end == chunk.end;
+  if (previous && size_of_free_space < header_size + machine_word) {
+    previous->set_alignment(previous->alignment() + size_of_free_space);
+    previous->set_last(last);
+    return previous;
+  }
+  auto new_header = new (start_of_free_space)
+      Header(size_of_free_space - header_size, previous, last);
+  if (previous) previous->set_last(false);
+  ++block_count_;
+  InsertFree(new_header);
+  if (storage_ != Storage::New && new_header->size() >= release_threshold) {
+    ReleaseBlock(new_header);
+  }
+  return new_header;
+}
+
+Heap::Handle Heap::MallocHandle(std::size_t size) {
+  std::size_t block_size;
+  if (__builtin_add_overflow(size, machine_word, &block_size)) return 0;
+  auto lock = Lock();
+  auto header = TakeFreeOrGrow(block_size);
+  if (!header) return 0;
+  SplitBlocks(header, block_size);
+  header->set_handle(true);
+  Handle handle;
+  if (free_handles_.empty()) {
+    handle = handles_.size();
+    handles_.emplace_back();
+  } else {
+    handle = free_handles_.back();
+    free_handles_.pop_back();
+  }
+  *reinterpret_cast<Handle *>(header->addr()) = handle;
+  handles_[handle] = {header->addr() + machine_word, 0};
+  ++counters_.allocations;
+  return handle;
+}
+
+void Heap::FreeHandle(Handle handle) {
+  auto lock = Lock();
+  if (handle >= handles_.size() || !handles_[handle].data) return;
+  ++counters_.frees;
+  FreeBlock(reinterpret_cast<Header *>(handles_[handle].data - machine_word -
+                                       header_size));
+  handles_[handle] = {};
+  free_handles_.push_back(handle);
+}
+
+void *Heap::Resolve(Handle handle) {
+  auto lock = Lock();
+  return handle < handles_.size() ? handles_[handle].data : nullptr;
+}
+
+void *Heap::Pin(Handle handle) {
+  auto lock = Lock();
+  if (handle >= handles_.size() || !handles_[handle].data) return nullptr;
+  ++handles_[handle].pins;
+  return handles_[handle].data;
+}
+
+void Heap::Unpin(Handle handle) {
+  auto lock = Lock();
+  if (handle < handles_.size() && handles_[handle].pins) {
+    --handles_[handle].pins;
+  }
+}
+
+// Only the word in front of the data of a handle block belongs to the heap;
+// the data of other blocks is written by their owners without the lock.
+Heap::Handle Heap::HandleOf(const Header *header) const noexcept {
+  return header->handle() ? *reinterpret_cast<const Handle *>(header->addr())
+                          : 0;
+}
+
+bool Heap::Pinned(const Header *header) const noexcept {
+  auto handle = HandleOf(header);
+  return handle && handles_[handle].pins;
+}
+
+std::size_t Heap::Compact(std::size_t max_bytes,
+                          std::chrono::microseconds max_time) {
+  auto lock = Lock();
+  auto deadline = std::chrono::steady_clock::now() + max_time;
+  std::size_t moved = 0;
+  for (std::size_t step = 0;; ++step) {
+    if (step % compact_clock_period == 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    if (!compact_cursor_) {
+      compact_chunk_ = 0;
+      compact_cursor_ = FirstHeader(chunks_.front());
+    }
+    auto current = compact_cursor_, next = current->next();
+    if (!next) {
+      if (++compact_chunk_ < chunks_.size()) {
+        compact_cursor_ = FirstHeader(chunks_[compact_chunk_]);
+        continue;
+      }
+      // A whole pass over the heap found nothing to do.
+      compact_cursor_ = nullptr;
+      if (!compact_pass_moved_) break;
+      compact_pass_moved_ = false;
+    } else if (current->state()) {
+      compact_cursor_ = next;
+    } else if (!next->state()) {
+      RemoveFree(current);
+      RemoveFree(next);
+      AbsorbNext(current);
+      InsertFree(current);
+      compact_pass_moved_ = true;
+    } else if (HandleOf(next) && !Pinned(next)) {
+      auto footprint = header_size + next->size() + next->alignment();
+      if (footprint > max_bytes - moved) {
+        // Blocks over the whole budget are skipped, so that they do not
+        // stop every later call at the same place.
+        if (moved) break;
+        compact_cursor_ = next;
+        continue;
+      }
+      compact_cursor_ = SlideBack(current, next);
+      compact_pass_moved_ = true;
+      moved += footprint;
     } else {
-      auto new_header =
-          new (start_of_free_space) Header{nullptr,
-                                           previous,
-                                           false,
-                                           size_of_free_space - header_size,
-                                           0,
-                                           start_of_free_space + header_size,
-                                           Heap::Type::Char};
-      previous->next = new_header;
-      free_blocks_.push_back(new_header);
+      compact_cursor_ = next;
     }
   }
+  return moved;
+}
+
+void Heap::StartCompactor(double threshold, std::chrono::milliseconds period,
+                          std::size_t max_bytes,
+                          std::chrono::microseconds max_time) {
+  StopCompactor();
+  // Calls take the heap lock while the compactor runs, whether or not the
+  // heap is concurrent; the thread caches stay as SetConcurrent left them.
+  compacting_ = true;
+  compactor_stop_ = false;
+  compactor_ = std::thread(&Heap::RunCompactor, this, threshold, period,
+                           max_bytes, max_time);
+}
+
+void Heap::StopCompactor() {
+  if (!compactor_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(compactor_mutex_);
+    compactor_stop_ = true;
+  }
+  compactor_wakeup_.notify_one();
+  compactor_.join();
+  compacting_ = false;
+}
+
+// Wakes up every period and, while the external fragmentation is above the
+// threshold, compacts in bounded steps. The heap lock is given up between
+// steps, so no call waits for more than one of them.
+void Heap::RunCompactor(double threshold, std::chrono::milliseconds period,
+                        std::size_t max_bytes,
+                        std::chrono::microseconds max_time) {
+  auto fragmented = [this, threshold] {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_bytes_ &&
+           1 - static_cast<double>(LargestFree()) / free_bytes_ > threshold;
+  };
+  auto stopped = [this] { return compactor_stop_.load(); };
+  std::unique_lock<std::mutex> lock(compactor_mutex_);
+  while (!compactor_wakeup_.wait_for(lock, period, stopped)) {
+    lock.unlock();
+    while (!stopped() && fragmented() && Compact(max_bytes, max_time)) {
+      std::this_thread::yield();
+    }
+    lock.lock();
+  }
+}
+
+// Moves a handle block to the start of the free block in front of it. The
+// free space ends up behind the block, merged with a free block there.
+Heap::Header *Heap::SlideBack(Header *free, Header *block) {
+  auto handle = HandleOf(block);
+  auto extra = block->alignment() - BlockAlignment(block->size());
+  auto gap = header_size + free->size() + extra;
+  auto last = block->last();
+  auto prev = free->prev();
+  RemoveFree(free);
+  std::copy_n(reinterpret_cast<std::byte *>(block),
+              header_size + block->size() + block->alignment() - extra,
+              reinterpret_cast<std::byte *>(free));
+  auto moved = free;
+  if (rover_ == block) rover_ = moved;
+  moved->set_prev(prev);
+  moved->set_alignment(moved->alignment() - extra);
+  moved->set_last(false);
+  handles_[handle].data = moved->addr() + machine_word;
+  auto rest = new (moved->addr() + moved->size() + moved->alignment())
+      Header(gap - header_size, moved, last);
+  if (rest->next()) rest->next()->set_prev(rest);
+  if (rest->next() && !rest->next()->state()) {
+    RemoveFree(rest->next());
+    AbsorbNext(rest);
+  }
+  InsertFree(rest);
+  return moved;
 }
 
 void Heap::Print() {
-  auto header = reinterpret_cast<Header *>(heap_.get());
-  for (auto current = header; current; current = current->next) {
-    std::cout << current->addr << "\n";
-    std::cout << "\tContent: ";
-    switch (current->type) {
-      case Type::Char:
-        PrintValue<char>(current->addr, current->size);
-        break;
-      case Type::Int:
-        PrintValue<int>(current->addr, current->size);
-        break;
-      case Type::Double:
-        PrintValue<double>(current->addr, current->size);
-        break;
+  auto lock = Lock();
+  for (auto &chunk : chunks_) {
+    for (auto current = FirstHeader(chunk); current;
+         current = current->next()) {
+      PrintBlock(current);
     }
-    std::cout << "\n"
-              << "\tSize: " << current->size << "\n\tState: " << current->state
-              << "\n";
   }
 }
 
+void Heap::PrintBlock(const Header *current) {
+  std::cout << current->addr() << "\n";
+  std::cout << "\tContent: ";
+  switch (current->type()) {
+    case Type::Char:
+      PrintValue<char>(current->addr(), current->size());
+      break;
+    case Type::Int:
+      PrintValue<int>(current->addr(), current->size());
+      break;
+    case Type::Double:
+      PrintValue<double>(current->addr(), current->size());
+      break;
+  }
+  std::cout << "\n"
+            << "\tSize: " << current->size()
+            << "\n\tState: " << current->state() << "\n";
+}
+
 template <class T>
 void Heap::PrintValue(std::byte *ptr, size_t size) {
   size_t num_of_elms = size / sizeof(T);
@@ -290,14 +1510,14 @@ void Heap::Write(void *ptr, Heap::Type type,
       WriteType<double>(ptr, value);
       break;
   }
-  header->type = type;
+  if (!FindSlab(ptr)) header->set_type(type);
 }
 
 const Heap::Header *Heap::GetFirstHeader() {
-  return reinterpret_cast<Header *>(heap_.get());
+  return FirstHeader(chunks_.front());
 }
 
-bool Heap::Empty() { return heap_ == nullptr; }
+bool Heap::Empty() { return chunks_.empty(); }
 
 template <class T>
 void Heap::WriteType(
@@ -311,85 +1531,250 @@ void Heap::WriteType(
   }
 }
 
+// The policy templates in the header call these with either counting.
+template Heap::Header *Heap::TakeFirstFit<policy::Counted>(std::size_t);
+template Heap::Header *Heap::TakeFirstFit<policy::Uncounted>(std::size_t);
+template Heap::Header *Heap::TakeNextFit<policy::Counted>(std::size_t);
+template Heap::Header *Heap::TakeNextFit<policy::Uncounted>(std::size_t);
+template Heap::Header *Heap::TakeBestFit<policy::Counted>(std::size_t);
+template Heap::Header *Heap::TakeBestFit<policy::Uncounted>(std::size_t);
+template Heap::Header *Heap::TakeFreeOrGrow<policy::Counted>(std::size_t);
+template Heap::Header *Heap::TakeFreeOrGrow<policy::Uncounted>(std::size_t);
+template void *Heap::SplitBlocks<policy::Counted>(Header *,
+                                                  std::size_t) noexcept;
+template void *Heap::SplitBlocks<policy::Uncounted>(Header *,
+                                                    std::size_t) noexcept;
+template void *Heap::ClearBlock<policy::Counted>(Header *,
+                                                 std::size_t) noexcept;
+template void *Heap::ClearBlock<policy::Uncounted>(Header *,
+                                                   std::size_t) noexcept;
+template void *Heap::ResizeBlock<policy::Counted>(Header *, std::size_t);
+template void *Heap::ResizeBlock<policy::Uncounted>(Header *, std::size_t);
+template void Heap::FreeBlock<policy::Counted>(Header *);
+template void Heap::FreeBlock<policy::Uncounted>(Header *);
+
 void *Memory::s21_malloc(std::size_t size) {
-  return Heap::GetInstance().Malloc(size);
+  auto ptr = buddy ? buddy->Malloc(size) : Heap::GetInstance().Malloc(size);
+  if (recorder) recorder->Malloc(size, ptr);
+  return ptr;
 }
 
 void *Memory::s21_malloc_onlyfree(std::size_t size) {
-  return Heap::GetInstance().MallocOnlyFree(size);
+  auto ptr =
+      buddy ? buddy->Malloc(size) : Heap::GetInstance().MallocOnlyFree(size);
+  if (recorder) recorder->Malloc(size, ptr);
+  return ptr;
+}
+
+void *Memory::s21_aligned_alloc(std::size_t alignment, std::size_t size) {
+  auto ptr = buddy ? buddy->AlignedMalloc(alignment, size)
+                   : Heap::GetInstance().AlignedMalloc(alignment, size);
+  if (recorder) recorder->AlignedMalloc(alignment, size, ptr);
+  return ptr;
+}
+
+std::size_t Memory::s21_malloc_batch(std::size_t size, std::size_t count,
+                                     void **out) {
+  std::size_t done = 0;
+  if (buddy) {
+    while (done < count && (out[done] = buddy->Malloc(size))) ++done;
+  } else {
+    done = Heap::GetInstance().MallocBatch(size, count, out);
+  }
+  if (recorder) {
+    for (std::size_t i = 0; i < done; ++i) recorder->Malloc(size, out[i]);
+  }
+  return done;
 }
 
 void *Memory::s21_calloc(std::size_t num, std::size_t size) {
-  return Heap::GetInstance().Calloc(num, size);
+  auto ptr = buddy ? buddy->Calloc(num, size)
+                   : Heap::GetInstance().Calloc(num, size);
+  if (recorder) recorder->Calloc(num, size, ptr);
+  return ptr;
 }
 
 void *Memory::s21_calloc_onlyfree(std::size_t num, std::size_t size) {
-  return Heap::GetInstance().CallocOnlyFree(num, size);
+  auto ptr = buddy ? buddy->Calloc(num, size)
+                   : Heap::GetInstance().CallocOnlyFree(num, size);
+  if (recorder) recorder->Calloc(num, size, ptr);
+  return ptr;
+}
+
+// Frees are recorded first: once the block is back in the heap, another
+// thread could get its address and record that allocation earlier.
+void Memory::s21_free(void *ptr) {
+  if (recorder) recorder->Free(ptr);
+  if (buddy) return buddy->Free(ptr);
+  Heap::GetInstance().Free(ptr);
 }
 
-void Memory::s21_free(void *ptr) { Heap::GetInstance().Free(ptr); }
+void Memory::s21_free_onlyfree(void *ptr) { s21_free(ptr); }
 
-void Memory::s21_free_onlyfree(void *ptr) { Heap::GetInstance().Free(ptr); }
+void Memory::s21_free_batch(void *const *ptrs, std::size_t count) {
+  if (recorder) {
+    for (std::size_t i = 0; i < count; ++i) recorder->Free(ptrs[i]);
+  }
+  if (!buddy) return Heap::GetInstance().FreeBatch(ptrs, count);
+  for (std::size_t i = 0; i < count; ++i) buddy->Free(ptrs[i]);
+}
 
 void *Memory::s21_realloc(void *ptr, std::size_t size) {
-  return Heap::GetInstance().Realloc(ptr, size);
+  if (buddy) {
+    if (!recorder) return buddy->Realloc(ptr, size);
+    return recorder->Realloc(ptr, size,
+                             [ptr, size] { return buddy->Realloc(ptr, size); });
+  }
+  auto &heap = Heap::GetInstance();
+  if (!recorder) return heap.Realloc(ptr, size);
+  return recorder->Realloc(
+      ptr, size, [&heap, ptr, size] { return heap.Realloc(ptr, size); });
 }
 
 void *Memory::s21_realloc_onlyfree(void *ptr, std::size_t size) {
-  return Heap::GetInstance().ReallocOnlyFree(ptr, size);
+  if (buddy) return s21_realloc(ptr, size);
+  auto &heap = Heap::GetInstance();
+  if (!recorder) return heap.ReallocOnlyFree(ptr, size);
+  return recorder->Realloc(ptr, size, [&heap, ptr, size] {
+    return heap.ReallocOnlyFree(ptr, size);
+  });
+}
+
+void Memory::s21_defragmentation() {
+  if (!recorder) return Heap::GetInstance().Defragmentation();
+  recorder->Defragmentation();
+  Heap::GetInstance().Defragmentation(
+      [](void *from, void *to) { recorder->Moved(from, to); });
+}
+
+void Memory::s21_start_recording(const std::string &path) {
+  recorder = std::make_unique<TraceWriter>(
+      path, buddy ? buddy->Capacity() : Heap::GetInstance().Capacity());
+}
+
+void Memory::s21_stop_recording() { recorder.reset(); }
+
+void Memory::s21_set_coalescing(bool coalescing) {
+  Heap::GetInstance().SetCoalescing(coalescing);
+}
+
+void Memory::s21_set_best_fit(bool best_fit) {
+  Heap::GetInstance().SetBestFit(best_fit);
+}
+
+void Memory::s21_set_placement(Heap::Placement placement) {
+  Heap::GetInstance().SetPlacement(placement);
 }
 
-void Memory::s21_defragmentation() { Heap::GetInstance().Defragmentation(); }
+void Memory::s21_set_concurrent(bool concurrent) {
+  Heap::GetInstance().SetConcurrent(concurrent);
+}
+
+void Memory::s21_set_growth(double factor, std::size_t max_size) {
+  Heap::GetInstance().SetGrowth(factor, max_size);
+}
 
-std::pair<std::chrono::milliseconds, std::chrono::milliseconds>
-Memory::s21_research(std::size_t percent) {
+void Memory::s21_set_slabs(bool slabs) {
+  Heap::GetInstance().SetSlabs(slabs);
+}
+
+Memory::Research Memory::s21_research(std::size_t percent) {
   if (percent < 1 || percent > 100) {
     throw std::invalid_argument("The research doesn't make sense");
   }
 
-  std::pair<std::chrono::milliseconds, std::chrono::milliseconds> time;
-  std::vector<int *> vector;
-  int *x;
+  auto measure = [percent](void *(*allocate)(std::size_t), bool coalescing,
+                           bool slabs = false,
+                           Heap::Placement placement =
+                               Heap::Placement::FirstFit,
+                           bool buddy_engine = false) {
+    std::vector<int *> vector;
+    int *x;
 
-  s21_init(1'000'000);
-  do {
-    x = reinterpret_cast<int *>(s21_malloc(10));
-    if (x != nullptr) {
-      vector.push_back(x);
-    }
-  } while (x != nullptr);
-  auto num_free_blocks = vector.size() / 100 * percent;
-  RandomlyFreeBlocks(vector, num_free_blocks);
-
-  auto start_time = std::chrono::high_resolution_clock::now();
-  do {
-    x = reinterpret_cast<int *>(s21_malloc(10));
-  } while (x != nullptr);
-  auto end_time = std::chrono::high_resolution_clock::now();
-  auto time_of_first_block =
-      std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
-                                                            start_time);
-  vector.clear();
-
-  s21_init(1'000'000);
-  do {
-    x = reinterpret_cast<int *>(s21_malloc_onlyfree(10));
-    if (x != nullptr) {
-      vector.push_back(x);
+    s21_init(1'000'000);
+    s21_set_coalescing(coalescing);
+    s21_set_slabs(slabs);
+    s21_set_placement(placement);
+    if (buddy_engine) s21_init_buddy(1'000'000);
+    do {
+      x = reinterpret_cast<int *>(allocate(10));
+      if (x != nullptr) {
+        vector.push_back(x);
+      }
+    } while (x != nullptr);
+    RandomlyFreeBlocks(vector, vector.size() / 100 * percent);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    do {
+      x = reinterpret_cast<int *>(allocate(10));
+    } while (x != nullptr);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                                 start_time);
+  };
+
+  Research research;
+  research.emplace_back("common funcs", measure(s21_malloc, false));
+  research.emplace_back("common funcs, coalescing",
+                        measure(s21_malloc, true));
+  research.emplace_back("segregated free lists",
+                        measure(s21_malloc_onlyfree, false));
+  research.emplace_back("segregated free lists, coalescing",
+                        measure(s21_malloc_onlyfree, true));
+  research.emplace_back(
+      "next fit", measure(s21_malloc, false, false, Heap::Placement::NextFit));
+  research.emplace_back(
+      "next fit, coalescing",
+      measure(s21_malloc, true, false, Heap::Placement::NextFit));
+  research.emplace_back(
+      "best fit", measure(s21_malloc, false, false, Heap::Placement::BestFit));
+  research.emplace_back(
+      "best fit, coalescing",
+      measure(s21_malloc, true, false, Heap::Placement::BestFit));
+  research.emplace_back(
+      "buddy",
+      measure(s21_malloc, true, false, Heap::Placement::FirstFit, true));
+  research.emplace_back("slabs", measure(s21_malloc, true, true));
+  s21_set_slabs(false);
+  s21_set_placement(Heap::Placement::FirstFit);
+
+  return research;
+}
+
+Memory::Research Memory::s21_research_threads(std::size_t max_threads) {
+  if (max_threads < 1) {
+    throw std::invalid_argument("The research doesn't make sense");
+  }
+
+  constexpr std::size_t operations = 1'000'000;
+  constexpr std::size_t live_blocks = 64;
+  auto work = [] {
+    std::vector<void *> blocks(live_blocks, nullptr);
+    for (std::size_t i = 0; i < operations; ++i) {
+      auto &block = blocks[i % live_blocks];
+      s21_free(block);
+      block = s21_malloc(8 + i % 16 * 8);
     }
-  } while (x != nullptr);
-  RandomlyFreeBlocks(vector, num_free_blocks);
+    for (auto block : blocks) s21_free(block);
+  };
 
-  start_time = std::chrono::high_resolution_clock::now();
-  do {
-    x = reinterpret_cast<int *>(s21_malloc_onlyfree(10));
-  } while (x != nullptr);
-  end_time = std::chrono::high_resolution_clock::now();
-  auto time_of_second_block =
-      std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
-                                                            start_time);
+  Research research;
+  s21_init(64'000'000);
+  s21_set_concurrent(true);
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    std::vector<std::thread> workers;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < threads; ++i) workers.emplace_back(work);
+    for (auto &worker : workers) worker.join();
+    auto end_time = std::chrono::high_resolution_clock::now();
+    research.emplace_back(
+        std::to_string(threads) + (threads == 1 ? " thread" : " threads"),
+        std::chrono::duration_cast<std::chrono::milliseconds>(end_time -
+                                                              start_time));
+  }
+  s21_set_concurrent(false);
 
-  return std::make_pair(time_of_first_block, time_of_second_block);
+  return research;
 }
 
 void Memory::RandomlyFreeBlocks(std::vector<int *> &blocks,
@@ -414,7 +1799,14 @@ void Memory::RandomlyFreeBlocks(std::vector<int *> &blocks,
   }
 }
 
-void Memory::s21_init(std::size_t size) { Heap::GetInstance(size); }
+void Memory::s21_init(std::size_t size, Heap::Storage storage) {
+  Heap::GetInstance(size, storage);
+  buddy.reset();
+}
+
+void Memory::s21_init_buddy(std::size_t size) {
+  buddy = BuddyHeap::Create(size);
+}
 
 void Memory::s21_write_value(
     void *ptr, s21::Heap::Type type,
@@ -427,4 +1819,40 @@ void Memory::s21_print() { Heap::GetInstance().Print(); }
 const Heap::Header *Memory::s21_get_first_header() {
   return Heap::GetInstance().GetFirstHeader();
 }
+
+Heap::Stats Memory::s21_get_stats() { return Heap::GetInstance().GetStats(); }
+
+Heap::Handle Memory::s21_malloc_handle(std::size_t size) {
+  return Heap::GetInstance().MallocHandle(size);
+}
+
+void Memory::s21_free_handle(Heap::Handle handle) {
+  Heap::GetInstance().FreeHandle(handle);
+}
+
+void *Memory::s21_resolve(Heap::Handle handle) {
+  return Heap::GetInstance().Resolve(handle);
+}
+
+void *Memory::s21_pin(Heap::Handle handle) {
+  return Heap::GetInstance().Pin(handle);
+}
+
+void Memory::s21_unpin(Heap::Handle handle) {
+  Heap::GetInstance().Unpin(handle);
+}
+
+std::size_t Memory::s21_compact(std::size_t max_bytes,
+                                std::chrono::microseconds max_time) {
+  return Heap::GetInstance().Compact(max_bytes, max_time);
+}
+
+void Memory::s21_start_compactor(double threshold,
+                                 std::chrono::milliseconds period,
+                                 std::size_t max_bytes,
+                                 std::chrono::microseconds max_time) {
+  Heap::GetInstance().StartCompactor(threshold, period, max_bytes, max_time);
+}
+
+void Memory::s21_stop_compactor() { Heap::GetInstance().StopCompactor(); }
 }  // namespace s21
\ No newline at end of file
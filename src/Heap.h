@@ -1,45 +1,170 @@
 #ifndef MEMORY_HEAP_H
 #define MEMORY_HEAP_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include "HeapPolicies.h"
+
 namespace s21 {
 class Heap {
  public:
   using heap_t = std::byte;
+  // Names a block that Compact and Defragmentation may move; 0 is no block.
+  using Handle = std::size_t;
   enum class Type : unsigned char {
     Char,
     Int,
     Double,
   };
-  struct Header {
-    Header* next{};
-    Header* prev{};
-    bool state{};
-    std::size_t size{};
-    std::size_t alignment{};
-    std::byte* addr{};
-    Type type{};
+  // Where the chunks of a heap live. New zero-fills every chunk up front;
+  // the mmap variants commit pages on first touch and hand large free
+  // regions back to the system.
+  enum class Storage : unsigned char {
+    New,
+    Mmap,
+    MmapHugePages,
+  };
+  // Where Malloc places blocks: the lowest free block that fits, the next
+  // one after the last placed block, or the smallest one that fits.
+  enum class Placement : unsigned char {
+    FirstFit,
+    NextFit,
+    BestFit,
+  };
+  // Block header of 16 bytes. The block's data starts right after it and
+  // the next block right after the data and its alignment, so neither is
+  // stored. The previous block is kept as a distance in machine words.
+  class Header {
+   public:
+    Header(std::size_t size, Header* prev, bool last) noexcept;
+
+    Header* next() noexcept;
+    const Header* next() const noexcept;
+    Header* prev() noexcept;
+    const Header* prev() const noexcept;
+    std::byte* addr() const noexcept;
+    std::size_t size() const noexcept;
+    bool state() const noexcept;
+    std::size_t alignment() const noexcept;
+    Type type() const noexcept;
+    bool last() const noexcept;
+    bool aligned() const noexcept;
+    bool zeroed() const noexcept;
+    bool handle() const noexcept;
+
+    void set_size(std::size_t size) noexcept;
+    void set_state(bool state) noexcept;
+    void set_alignment(std::size_t alignment) noexcept;
+    void set_type(Type type) noexcept;
+    void set_prev(const Header* prev) noexcept;
+    void set_last(bool last) noexcept;
+    void set_aligned(bool aligned) noexcept;
+    void set_zeroed(bool zeroed) noexcept;
+    void set_handle(bool handle) noexcept;
+
+   private:
+    // Sizes never reach the top 16 bits of the size word, so an allocated
+    // block keeps a tag there: a single state bit would let Free accept
+    // almost any foreign pointer. The lowest bit of the tag marks a block
+    // placed at a requested alignment, which must not be moved. A free block
+    // has the next bit set while its data past the first word is zero. The
+    // third bit marks a handle block, so that the compactor tells them apart
+    // without reading the data of other blocks.
+    constexpr static std::size_t tag_shift = sizeof(std::size_t) * 8 - 16;
+    constexpr static std::size_t tag_mask = std::size_t{0xFFFF} << tag_shift;
+    constexpr static std::size_t used_tag = std::size_t{0xA110} << tag_shift;
+    constexpr static std::size_t aligned_bit = std::size_t{1} << tag_shift;
+    constexpr static std::size_t zeroed_bit = std::size_t{2} << tag_shift;
+    constexpr static std::size_t handle_bit = std::size_t{4} << tag_shift;
+
+    std::size_t size_state_;
+    std::uint32_t prev_offset_;
+    std::uint16_t alignment_;
+    Type type_;
+    bool last_;
   };
+  struct Stats;
 
  public:
   Heap(const Heap&) = delete;
   Heap& operator=(const Heap&) = delete;
+  ~Heap();
 
-  static Heap& GetInstance(std::size_t size = 0);
+  static Heap& GetInstance(std::size_t size = 0,
+                           Storage storage = Storage::New);
+  static std::unique_ptr<Heap> Create(std::size_t size,
+                                      Storage storage = Storage::New);
+  // The placement, locking and counting of a call are chosen at compile
+  // time. The functions below are these with policy::Configured.
+  template <class Placement = policy::Configured,
+            class Locking = policy::Configured,
+            class Counting = policy::Counted>
+  void* Allocate(std::size_t size);
+  template <class Placement = policy::Configured,
+            class Locking = policy::Configured,
+            class Counting = policy::Counted>
+  void* AllocateZeroed(std::size_t num, std::size_t size);
+  template <class Placement = policy::Configured,
+            class Locking = policy::Configured,
+            class Counting = policy::Counted>
+  void* Reallocate(void* ptr, std::size_t size);
+  template <class Locking = policy::Configured,
+            class Counting = policy::Counted>
+  void Deallocate(void* ptr);
   void* Malloc(std::size_t size);
   void* MallocOnlyFree(std::size_t size);
+  void* AlignedMalloc(std::size_t alignment, std::size_t size);
+  std::size_t MallocBatch(std::size_t size, std::size_t count, void** out);
   void* Calloc(std::size_t num, std::size_t size);
   void* CallocOnlyFree(std::size_t num, std::size_t size);
   void Free(void* ptr);
+  void Free(void* ptr, std::size_t size);
+  void FreeBatch(void* const* ptrs, std::size_t count);
+  std::size_t UsableSize(void* ptr);
+  void SetCoalescing(bool coalescing) noexcept;
+  void SetPlacement(Placement placement);
+  void SetBestFit(bool best_fit);
+  void SetConcurrent(bool concurrent);
+  void SetGrowth(double factor, std::size_t max_size);
+  void SetSlabs(bool slabs);
+  // Places the data of every block on 8 or 16 bytes. Slab slots stay on 8.
+  void SetMinAlignment(std::size_t alignment);
+  std::size_t Capacity() const noexcept;
+  Stats GetStats();
   void* Realloc(void* ptr, std::size_t size);
   void* ReallocOnlyFree(void* ptr, std::size_t size);
   void Defragmentation();
+  // Passes the old and the new address of every block it moves.
+  void Defragmentation(const std::function<void(void*, void*)>& moved);
+  Handle MallocHandle(std::size_t size);
+  void FreeHandle(Handle handle);
+  void* Resolve(Handle handle);
+  void* Pin(Handle handle);
+  void Unpin(Handle handle);
+  std::size_t Compact(std::size_t max_bytes,
+                      std::chrono::microseconds max_time);
+  void StartCompactor(double threshold, std::chrono::milliseconds period,
+                      std::size_t max_bytes,
+                      std::chrono::microseconds max_time);
+  void StopCompactor();
   void Print();
   const Header* GetFirstHeader();
   void Write(void* ptr, Heap::Type type,
@@ -47,17 +172,178 @@ class Heap {
   bool Empty();
 
  private:
-  Heap() = default;
+  Heap();
 
   constexpr static std::size_t header_size = sizeof(Header);
   constexpr static std::size_t machine_word = sizeof(std::size_t);
+  // Bounded by the 32-bit distance to the previous block in the header.
+  constexpr static std::size_t max_chunk_size =
+      std::size_t{UINT32_MAX} * machine_word;
+  constexpr static std::size_t bins_count = 64;
+  constexpr static std::size_t release_threshold = 128 * 1024;
+  constexpr static std::size_t cache_max_size = 256;
+  constexpr static std::size_t cache_classes =
+      cache_max_size / machine_word + 1;
+  constexpr static std::size_t cache_batch = 32;
+  constexpr static std::size_t slab_size = 4096;
+  constexpr static std::size_t slab_max_size = 128;
+  constexpr static std::size_t slab_classes = slab_max_size / machine_word;
+  constexpr static std::size_t compact_clock_period = 64;
+  // Larger blocks are cleared with stores that bypass the cache.
+  constexpr static std::size_t stream_clear_size = 8 * 1024 * 1024;
+
+  struct ChunkDeleter {
+    std::size_t size;
+    bool mapped;
+    void operator()(heap_t* memory) const noexcept;
+  };
+
+  // A contiguous piece of heap memory with its own list of blocks.
+  struct Chunk {
+    std::unique_ptr<heap_t, ChunkDeleter> memory;
+    heap_t* end{};
+  };
+
+  struct Counters {
+    std::uint64_t allocations = 0;
+    std::uint64_t frees = 0;
+    std::uint64_t reallocations = 0;
+    std::uint64_t defragmentations = 0;
+  };
+
+  struct HandleEntry {
+    heap_t* data;
+    std::uint32_t pins;
+  };
+
+  struct ThreadCache;
+
+  // Shared by a heap and the thread caches created for it, so that a cache
+  // outliving its heap can tell the heap is gone.
+  struct CacheRegistry {
+    std::mutex mutex;
+    Heap* heap{};
+    std::vector<ThreadCache*> caches;
+  };
+
+  // Small blocks owned by one thread. They stay allocated in the heap and are
+  // handed out again without taking the heap lock; the heap is only locked
+  // to refill a size class or to flush an overfull one.
+  struct ThreadCache {
+    explicit ThreadCache(std::shared_ptr<CacheRegistry> registry);
+    ~ThreadCache();
 
-  void UpdateSize(size_t size);
+    std::shared_ptr<CacheRegistry> registry;
+    std::mutex mutex;
+    std::array<std::vector<Header*>, cache_classes> blocks;
+    Counters counters;
+  };
+
+  // A slab_size-aligned run of equal slots filling the data of one heap
+  // block. Slots have no header: a slot's slab is found by rounding its
+  // address down. Freed slots form a stack threaded through their first word.
+  struct Slab {
+    Slab* prev;
+    Slab* next;
+    void* free_slots;
+    std::uint32_t slot_size;
+    std::uint32_t used;
+    std::uint32_t untouched;
+    std::uint32_t capacity;
+  };
+
+  void UpdateSize(size_t size, Storage storage);
+  template <class Counting = policy::Counted>
+  Header* AddChunk(std::size_t size);
+  template <class Counting = policy::Counted>
+  Header* Grow(std::size_t size);
+  template <class Counting = policy::Counted>
+  bool ReleaseChunk(Header* header);
+  static std::size_t PageSize() noexcept;
+  static void ReleasePages(heap_t* begin, heap_t* end) noexcept;
+  void ReleaseBlock(Header* header) noexcept;
+  static void ClearMemory(std::byte* begin, std::size_t size) noexcept;
+  static Header* FirstHeader(const Chunk& chunk) noexcept;
+  void DefragmentChunk(Chunk& chunk,
+                       const std::function<void(void*, void*)>& moved);
+  Handle HandleOf(const Header* header) const noexcept;
+  bool Pinned(const Header* header) const noexcept;
+  Header* SlideBack(Header* free, Header* block);
+  void RunCompactor(double threshold, std::chrono::milliseconds period,
+                    std::size_t max_bytes, std::chrono::microseconds max_time);
+  std::size_t LargestFree() noexcept;
+  void PrintBlock(const Header* current);
+  template <class Placement, class Counting>
+  void* Place(std::size_t size);
+  template <class Placement, class Counting>
+  Header* Take(std::size_t size);
+  template <class Locking>
+  std::unique_lock<std::mutex> LockFor();
+  template <class Locking>
+  bool Cached(std::size_t size) const noexcept;
+  template <class Counting>
+  void* Count(void* ptr) noexcept;
+  template <class Counting = policy::Counted>
+  Header* TakeFirstFit(std::size_t size);
+  template <class Counting = policy::Counted>
+  Header* TakeNextFit(std::size_t size);
+  template <class Counting = policy::Counted>
+  Header* TakeBestFit(std::size_t size);
+  void KeepTree();
+  std::unique_lock<std::mutex> Lock();
+  std::vector<std::unique_lock<std::mutex>> LockCaches();
+  ThreadCache& LocalCache();
+  void* CachedMalloc(std::size_t size);
+  void CachedFree(Header* header);
+  void ReturnCachedBlocks(ThreadCache& cache);
+  Slab* NewSlab(std::size_t slot_size);
+  void* SlabMalloc(std::size_t size);
+  void SlabFree(Slab& slab, void* ptr);
+  template <class Placement, class Counting>
+  void* MoveSlot(Slab& slab, void* ptr, std::size_t size);
+  Slab* FindSlab(const void* ptr) const;
+  static void LinkSlab(Slab*& list, Slab& slab) noexcept;
+  static void UnlinkSlab(Slab*& list, Slab& slab) noexcept;
+  void ReleaseSlab(Slab& slab);
+  void ReleaseEmptySlabs();
+  Header* AlignBlock(Header* header, std::size_t alignment);
+  static std::uintptr_t AlignedAddress(std::uintptr_t address,
+                                       std::size_t alignment) noexcept;
+  Header* TakeAligned(std::size_t alignment, std::size_t size);
+  Header* FillGap(const Chunk& chunk, Header* previous, heap_t* end);
   static std::size_t Align(std::size_t size) noexcept;
+  std::size_t BlockAlignment(std::size_t size) const noexcept;
+  static std::uint32_t& FreeIndex(Header* header) noexcept;
+  static void SiftBin(std::vector<Header*>& blocks,
+                      std::size_t index) noexcept;
   static Header* FindPointer(void* ptr);
+  template <class Counting = policy::Counted>
   void* SplitBlocks(Header* header, size_t new_current_block_size) noexcept;
-  void* ExpOrMoveBlock(Header* header, size_t size);
+  std::size_t CarveBlocks(Header* header, std::size_t size, std::size_t count,
+                          void** out) noexcept;
+  template <class Placement, class Counting>
+  void* ExpOrMoveBlock(Header* header, std::size_t size);
+  template <class Counting = policy::Counted>
+  void* ResizeBlock(Header* header, std::size_t size);
+  template <class Counting = policy::Counted>
   bool MergeBlocks(Header* header);
+  void AbsorbNext(Header* header) noexcept;
+  void FreeHeader(Header* header);
+  template <class Counting = policy::Counted>
+  void FreeBlock(Header* header);
+  static std::size_t BinIndex(std::size_t size) noexcept;
+  template <class Counting = policy::Counted>
+  void InsertFree(Header* header);
+  template <class Counting = policy::Counted>
+  void RemoveFree(Header* header);
+  template <class Counting = policy::Counted>
+  Header* TakeFree(std::size_t size);
+  template <class Counting = policy::Counted>
+  Header* TakeFreeOrGrow(std::size_t size);
+  void ClearFree() noexcept;
+  void* CountAllocation(void* ptr) noexcept;
+  template <class Counting = policy::Counted>
+  void* ClearBlock(Header* header, std::size_t size) noexcept;
   template <class T>
   void PrintValue(std::byte* ptr, size_t size);
   template <class T>
@@ -66,26 +352,278 @@ class Heap {
       const std::vector<std::variant<char, int, double>>& value) const;
 
  private:
-  std::unique_ptr<heap_t[]> heap_;
-  heap_t* end_ = nullptr;
-  std::vector<Header*> free_blocks_;
+  std::vector<Chunk> chunks_;
+  std::size_t capacity_ = 0;
+  Storage storage_ = Storage::New;
+  double growth_factor_ = 2;
+  std::size_t max_size_ = 0;
+  // Each bin is ordered as a binary max-heap by size, and a free block
+  // keeps its place in the bin in its first word. Uncounted calls leave
+  // the bins they change unordered until LargestFree reads them.
+  std::array<std::vector<Header*>, bins_count> free_bins_;
+  std::uint64_t non_empty_bins_ = 0;
+  std::uint64_t unordered_bins_ = 0;
+  // The free blocks by size and address, kept from the first best-fit
+  // placement on, so that the tightest block is found in logarithmic time.
+  Placement placement_ = Placement::FirstFit;
+  bool tree_kept_ = false;
+  std::set<std::pair<std::size_t, Header*>> free_tree_;
+  bool coalescing_ = true;
+  std::size_t min_alignment_ = machine_word;
+  bool concurrent_ = false;
+  // Set while the compactor thread runs, so that every call locks the heap.
+  bool compacting_ = false;
+  std::mutex mutex_;
+  std::shared_ptr<CacheRegistry> registry_;
+  bool slabs_ = false;
+  std::array<Slab*, slab_classes> partial_slabs_{};
+  std::unordered_set<const heap_t*> slab_set_;
+  std::atomic<bool> has_slabs_{false};
+  // Kept up to date by every change to the blocks, so that GetStats does not
+  // walk the heap. The largest free block is the first of the highest
+  // non-empty bin.
+  std::size_t block_count_ = 0;
+  std::size_t free_bytes_ = 0;
+  Counters counters_;
+  // Handle blocks by handle. A handle block keeps its handle in the word in
+  // front of the data, so a move can update the table.
+  std::vector<HandleEntry> handles_{HandleEntry{}};
+  std::vector<Handle> free_handles_;
+  // Where next fit resumes; moved back like the compaction cursor.
+  Header* rover_ = nullptr;
+  std::size_t rover_chunk_ = 0;
+  // Where Compact resumes; moved back when the block under it is merged.
+  Header* compact_cursor_ = nullptr;
+  std::size_t compact_chunk_ = 0;
+  bool compact_pass_moved_ = false;
+  std::thread compactor_;
+  std::mutex compactor_mutex_;
+  std::condition_variable compactor_wakeup_;
+  std::atomic<bool> compactor_stop_{false};
 };
 
+// A snapshot of a heap. Bytes in use include the padding of allocated blocks,
+// whole slabs and blocks held by thread caches; headers count as neither.
+struct Heap::Stats {
+  std::size_t capacity;
+  std::size_t bytes_in_use;
+  std::size_t bytes_free;
+  std::size_t used_blocks;
+  std::size_t free_blocks;
+  std::size_t largest_free_block;
+  // Share of the free bytes that cannot be handed out in one block.
+  double external_fragmentation;
+  // Free blocks of sizes from 2^i to 2^(i + 1) - 1 bytes at index i.
+  std::array<std::size_t, bins_count> free_blocks_by_size;
+  std::uint64_t allocations;
+  std::uint64_t frees;
+  std::uint64_t reallocations;
+  std::uint64_t defragmentations;
+};
+
+template <class Placement, class Locking, class Counting>
+void* Heap::Allocate(std::size_t size) {
+  if constexpr (std::is_same_v<Locking, policy::Configured>) {
+    if (slabs_ && size && size <= slab_max_size) {
+      auto lock = Lock();
+      auto ptr = SlabMalloc(size);
+      return Count<Counting>(ptr ? ptr : Place<Placement, Counting>(size));
+    }
+  }
+  if (Cached<Locking>(size)) return CachedMalloc(size);
+  auto lock = LockFor<Locking>();
+  return Count<Counting>(Place<Placement, Counting>(size));
+}
+
+// Blocks taken from zeroed free blocks only need the word that held their
+// place in the bins cleared. Slots and cached blocks are always cleared.
+template <class Placement, class Locking, class Counting>
+void* Heap::AllocateZeroed(std::size_t num, std::size_t size) {
+  std::size_t total_size;
+  if (__builtin_mul_overflow(num, size, &total_size)) return nullptr;
+  auto pooled = Cached<Locking>(total_size);
+  if constexpr (std::is_same_v<Locking, policy::Configured>) {
+    pooled = pooled || (slabs_ && total_size && total_size <= slab_max_size);
+  }
+  if (pooled) {
+    auto ptr = Allocate<Placement, Locking, Counting>(total_size);
+    if (ptr) ClearMemory(static_cast<std::byte*>(ptr), total_size);
+    return ptr;
+  }
+  auto lock = LockFor<Locking>();
+  return Count<Counting>(ClearBlock<Counting>(
+      Take<Placement, Counting>(total_size), total_size));
+}
+
+template <class Placement, class Locking, class Counting>
+void* Heap::Reallocate(void* ptr, std::size_t size) {
+  if (!ptr) return Allocate<Placement, Locking, Counting>(size);
+  auto lock = LockFor<Locking>();
+  auto slab = FindSlab(ptr);
+  auto new_ptr =
+      slab ? MoveSlot<Placement, Counting>(*slab, ptr, size)
+           : ExpOrMoveBlock<Placement, Counting>(FindPointer(ptr), size);
+  if constexpr (std::is_same_v<Counting, policy::Counted>) {
+    if (new_ptr) ++counters_.reallocations;
+  }
+  return new_ptr;
+}
+
+template <class Locking, class Counting>
+void Heap::Deallocate(void* ptr) {
+  constexpr auto counted = std::is_same_v<Counting, policy::Counted>;
+  if (has_slabs_) {
+    auto lock = LockFor<Locking>();
+    if (auto slab = FindSlab(ptr)) {
+      if constexpr (counted) ++counters_.frees;
+      return SlabFree(*slab, ptr);
+    }
+  }
+  auto header = FindPointer(ptr);
+  if (!header) return;
+  if (!header->aligned() &&
+      Cached<Locking>(header->size() + header->alignment())) {
+    return CachedFree(header);
+  }
+  auto lock = LockFor<Locking>();
+  if constexpr (counted) ++counters_.frees;
+  FreeBlock<Counting>(header);
+}
+
+template <class Placement, class Counting>
+void* Heap::Place(std::size_t size) {
+  auto header = Take<Placement, Counting>(size);
+  return header ? SplitBlocks<Counting>(header, size) : nullptr;
+}
+
+template <class Placement, class Counting>
+Heap::Header* Heap::Take(std::size_t size) {
+  if constexpr (std::is_same_v<Placement, policy::FirstFit>) {
+    return TakeFirstFit<Counting>(size);
+  } else if constexpr (std::is_same_v<Placement, policy::NextFit>) {
+    return TakeNextFit<Counting>(size);
+  } else if constexpr (std::is_same_v<Placement, policy::BestFit>) {
+    if (!tree_kept_) KeepTree();
+    return TakeBestFit<Counting>(size);
+  } else if constexpr (std::is_same_v<Placement, policy::SegregatedFit>) {
+    return TakeFreeOrGrow<Counting>(size);
+  } else {
+    static_assert(std::is_same_v<Placement, policy::Configured>);
+    switch (placement_) {
+      case Heap::Placement::NextFit:
+        return TakeNextFit<Counting>(size);
+      case Heap::Placement::BestFit:
+        return TakeBestFit<Counting>(size);
+      default:
+        return TakeFirstFit<Counting>(size);
+    }
+  }
+}
+
+// A slot that has to grow moves to a larger slot, or to a block placed by
+// the policy.
+template <class Placement, class Counting>
+void* Heap::MoveSlot(Slab& slab, void* ptr, std::size_t size) {
+  if (size <= slab.slot_size) return ptr;
+  auto new_ptr = slabs_ && size <= slab_max_size ? SlabMalloc(size) : nullptr;
+  if (!new_ptr) new_ptr = Place<Placement, Counting>(size);
+  if (new_ptr) {
+    std::copy_n(static_cast<std::byte*>(ptr), slab.slot_size,
+                static_cast<std::byte*>(new_ptr));
+    SlabFree(slab, ptr);
+  }
+  return new_ptr;
+}
+
+// A block that cannot be resized where it is moves to a block placed by the
+// policy.
+template <class Placement, class Counting>
+void* Heap::ExpOrMoveBlock(Header* header, std::size_t size) {
+  if (auto ptr = ResizeBlock<Counting>(header, size)) return ptr;
+  auto new_ptr = Place<Placement, Counting>(size);
+  if (new_ptr) {
+    std::copy_n(header->addr(), header->size() + header->alignment(),
+                static_cast<std::byte*>(new_ptr));
+    FreeBlock<Counting>(header);
+  }
+  return new_ptr;
+}
+
+template <class Locking>
+std::unique_lock<std::mutex> Heap::LockFor() {
+  if constexpr (std::is_same_v<Locking, policy::Unlocked>) {
+    return std::unique_lock<std::mutex>();
+  } else if constexpr (std::is_same_v<Locking, policy::Configured>) {
+    return Lock();
+  } else {
+    return std::unique_lock<std::mutex>(mutex_);
+  }
+}
+
+// Whether blocks of the size come from the thread caches.
+template <class Locking>
+bool Heap::Cached(std::size_t size) const noexcept {
+  if constexpr (std::is_same_v<Locking, policy::ThreadCached>) {
+    return size && size <= cache_max_size;
+  } else if constexpr (std::is_same_v<Locking, policy::Configured>) {
+    return concurrent_ && size && size <= cache_max_size;
+  } else {
+    return false;
+  }
+}
+
+template <class Counting>
+void* Heap::Count(void* ptr) noexcept {
+  if constexpr (std::is_same_v<Counting, policy::Counted>) {
+    return CountAllocation(ptr);
+  }
+  return ptr;
+}
+
 namespace Memory {
-void s21_init(std::size_t size);
+using Research = std::vector<std::pair<std::string, std::chrono::milliseconds>>;
+
+void s21_init(std::size_t size, Heap::Storage storage = Heap::Storage::New);
+// Serves the allocation functions from a buddy heap of the size, rounded up
+// to a power of two, until the next s21_init. The functions that deal with
+// headers, handles, statistics and settings still act on the block heap.
+void s21_init_buddy(std::size_t size);
 void* s21_malloc(std::size_t size);
 void* s21_malloc_onlyfree(std::size_t size);
+void* s21_aligned_alloc(std::size_t alignment, std::size_t size);
+std::size_t s21_malloc_batch(std::size_t size, std::size_t count, void** out);
 void* s21_calloc(std::size_t num, std::size_t size);
 void* s21_calloc_onlyfree(std::size_t num, std::size_t size);
 void s21_free(void* ptr);
 void s21_free_onlyfree(void* ptr);
+void s21_free_batch(void* const* ptrs, std::size_t count);
 void* s21_realloc(void* ptr, std::size_t size);
 void* s21_realloc_onlyfree(void* ptr, std::size_t size);
 void s21_defragmentation();
-std::pair<std::chrono::milliseconds, std::chrono::milliseconds> s21_research(
-    std::size_t percent);
+void s21_set_coalescing(bool coalescing);
+void s21_set_best_fit(bool best_fit);
+void s21_set_placement(Heap::Placement placement);
+void s21_set_concurrent(bool concurrent);
+void s21_set_growth(double factor, std::size_t max_size);
+void s21_set_slabs(bool slabs);
+void s21_start_recording(const std::string& path);
+void s21_stop_recording();
+Research s21_research(std::size_t percent);
+Research s21_research_threads(std::size_t max_threads);
 void RandomlyFreeBlocks(std::vector<int*>& blocks, std::size_t num_free_blocks);
 const Heap::Header* s21_get_first_header();
+Heap::Stats s21_get_stats();
+Heap::Handle s21_malloc_handle(std::size_t size);
+void s21_free_handle(Heap::Handle handle);
+void* s21_resolve(Heap::Handle handle);
+void* s21_pin(Heap::Handle handle);
+void s21_unpin(Heap::Handle handle);
+std::size_t s21_compact(std::size_t max_bytes,
+                        std::chrono::microseconds max_time);
+void s21_start_compactor(double threshold, std::chrono::milliseconds period,
+                         std::size_t max_bytes,
+                         std::chrono::microseconds max_time);
+void s21_stop_compactor();
 void s21_print();
 void s21_write_value(void* ptr, Heap::Type type,
                      const std::vector<std::variant<char, int, double>>& input);
@@ -0,0 +1,27 @@
+#include "HeapAllocator.h"
+
+namespace s21 {
+
+HeapResource::HeapResource() : heap_(&Heap::GetInstance()) {}
+
+HeapResource::HeapResource(Heap &heap) noexcept : heap_(&heap) {}
+
+Heap &HeapResource::heap() const noexcept { return *heap_; }
+
+void *HeapResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+  auto ptr = heap_->AlignedMalloc(alignment, bytes);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void HeapResource::do_deallocate(void *ptr, std::size_t bytes, std::size_t) {
+  heap_->Free(ptr, bytes);
+}
+
+bool HeapResource::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  auto resource = dynamic_cast<const HeapResource *>(&other);
+  return resource && resource->heap_ == heap_;
+}
+
+}  // namespace s21
@@ -0,0 +1,81 @@
+#ifndef MEMORY_HEAP_ALLOCATOR_H
+#define MEMORY_HEAP_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+
+#include "Heap.h"
+
+namespace s21 {
+// Allocator for standard containers. Memory is given back with its size,
+// which lets the heap skip the slab lookup for larger blocks.
+template <class T>
+class HeapAllocator {
+ public:
+  using value_type = T;
+
+  // Uses the heap of the s21::Memory functions.
+  HeapAllocator() : heap_(&Heap::GetInstance()) {}
+  explicit HeapAllocator(Heap& heap) noexcept : heap_(&heap) {}
+  template <class U>
+  HeapAllocator(const HeapAllocator<U>& other) noexcept
+      : heap_(&other.heap()) {}
+
+  T* allocate(std::size_t n);
+  void deallocate(T* ptr, std::size_t n) noexcept;
+  Heap& heap() const noexcept { return *heap_; }
+
+ private:
+  Heap* heap_;
+};
+
+template <class T, class U>
+bool operator==(const HeapAllocator<T>& lhs,
+                const HeapAllocator<U>& rhs) noexcept {
+  return &lhs.heap() == &rhs.heap();
+}
+
+template <class T, class U>
+bool operator!=(const HeapAllocator<T>& lhs,
+                const HeapAllocator<U>& rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+template <class T>
+T* HeapAllocator<T>::allocate(std::size_t n) {
+  if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+    throw std::bad_array_new_length();
+  }
+  auto ptr = heap_->AlignedMalloc(alignof(T), n * sizeof(T));
+  if (!ptr) throw std::bad_alloc();
+  return static_cast<T*>(ptr);
+}
+
+template <class T>
+void HeapAllocator<T>::deallocate(T* ptr, std::size_t n) noexcept {
+  heap_->Free(ptr, n * sizeof(T));
+}
+
+// Memory resource for the std::pmr containers.
+class HeapResource : public std::pmr::memory_resource {
+ public:
+  HeapResource();
+  explicit HeapResource(Heap& heap) noexcept;
+
+  Heap& heap() const noexcept;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* ptr, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override;
+
+  Heap* heap_;
+};
+
+}  // namespace s21
+
+#endif  // MEMORY_HEAP_ALLOCATOR_H
@@ -0,0 +1,31 @@
+#ifndef MEMORY_HEAP_POLICIES_H
+#define MEMORY_HEAP_POLICIES_H
+
+namespace s21 {
+// Policies for the Heap::Allocate templates. Every combination compiles to
+// its own path, so a choice made here costs no branch on each call; only
+// Configured reads the heap's settings at run time.
+namespace policy {
+// Placement: the free block a new block is carved from.
+struct FirstFit {};       // the lowest block in address order
+struct NextFit {};        // the next block from where the last search ended
+struct BestFit {};        // the smallest block, from the size-ordered tree
+struct SegregatedFit {};  // a block from the lowest size bin that fits
+
+// Locking: how calls of several threads are kept apart.
+struct Unlocked {};      // the caller keeps the heap to one thread
+struct Locked {};        // the heap mutex around every call
+struct ThreadCached {};  // small blocks from per-thread caches
+
+// Counting: whether a call keeps the statistics. Uncounted calls leave the
+// counters alone and do not keep the bins ordered by size.
+struct Counted {};
+struct Uncounted {};
+
+// As set on the heap at run time: placement by SetPlacement, locking and
+// slabs by SetConcurrent and SetSlabs.
+struct Configured {};
+}  // namespace policy
+}  // namespace s21
+
+#endif  // MEMORY_HEAP_POLICIES_H
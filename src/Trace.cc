@@ -0,0 +1,170 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace s21 {
+
+namespace {
+constexpr char trace_magic[] = {'S', '2', '1', 'T', 'R', 'C', '0', '1'};
+}
+
+TraceWriter::TraceWriter(const std::string &path, std::size_t heap_size)
+    : out_(path, std::ios::binary | std::ios::trunc),
+      start_(std::chrono::steady_clock::now()) {
+  if (!out_) throw std::runtime_error("Can't open trace file " + path);
+  out_.write(trace_magic, sizeof(trace_magic));
+  WriteVarint(heap_size);
+}
+
+void TraceWriter::Malloc(std::size_t size, const void *result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Append({TraceOp::Kind::Malloc, 0, NewId(result), 0, 0, size});
+}
+
+void TraceWriter::Calloc(std::size_t num, std::size_t size,
+                         const void *result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Append({TraceOp::Kind::Calloc, 0, NewId(result), 0, num, size});
+}
+
+void TraceWriter::AlignedMalloc(std::size_t alignment, std::size_t size,
+                                const void *result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Append({TraceOp::Kind::AlignedMalloc, 0, NewId(result), 0, alignment, size});
+}
+
+void TraceWriter::Free(const void *ptr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Append({TraceOp::Kind::Free, 0, TakeId(ptr), 0, 0, 0});
+}
+
+void TraceWriter::Defragmentation() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Append({TraceOp::Kind::Defragmentation, 0, 0, 0, 0, 0});
+}
+
+void TraceWriter::Moved(const void *from, const void *to) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto id = ids_.extract(from);
+  if (!id) return;
+  id.key() = to;
+  ids_.insert(std::move(id));
+}
+
+std::uint64_t TraceWriter::NewId(const void *result) {
+  if (!result) return 0;
+  ids_[result] = next_id_;
+  return next_id_++;
+}
+
+std::uint64_t TraceWriter::FindId(const void *ptr) const {
+  auto id = ids_.find(ptr);
+  return id == ids_.end() ? 0 : id->second;
+}
+
+std::uint64_t TraceWriter::TakeId(const void *ptr) {
+  auto id = FindId(ptr);
+  ids_.erase(ptr);
+  return id;
+}
+
+void TraceWriter::Append(const TraceOp &op) {
+  auto time = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count());
+  out_.put(static_cast<char>(op.kind));
+  WriteVarint(time - last_time_);
+  last_time_ = time;
+  switch (op.kind) {
+    case TraceOp::Kind::Malloc:
+      WriteVarint(op.size);
+      WriteVarint(op.id);
+      break;
+    case TraceOp::Kind::Calloc:
+    case TraceOp::Kind::AlignedMalloc:
+      WriteVarint(op.num);
+      WriteVarint(op.size);
+      WriteVarint(op.id);
+      break;
+    case TraceOp::Kind::Realloc:
+      WriteVarint(op.old_id);
+      WriteVarint(op.size);
+      WriteVarint(op.id);
+      break;
+    case TraceOp::Kind::Free:
+      WriteVarint(op.id);
+      break;
+    case TraceOp::Kind::Defragmentation:
+      break;
+  }
+}
+
+void TraceWriter::WriteVarint(std::uint64_t value) {
+  while (value >= 0x80) {
+    out_.put(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out_.put(static_cast<char>(value));
+}
+
+TraceReader::TraceReader(const std::string &path)
+    : in_(path, std::ios::binary) {
+  char magic[sizeof(trace_magic)];
+  if (!in_.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), trace_magic)) {
+    throw std::runtime_error("Not a trace file: " + path);
+  }
+  heap_size_ = ReadVarint();
+}
+
+std::size_t TraceReader::HeapSize() const noexcept { return heap_size_; }
+
+bool TraceReader::Next(TraceOp &op) {
+  auto kind = in_.get();
+  if (kind == std::ifstream::traits_type::eof()) return false;
+  if (kind > static_cast<int>(TraceOp::Kind::AlignedMalloc)) {
+    throw std::runtime_error("Corrupted trace");
+  }
+  op = {static_cast<TraceOp::Kind>(kind), time_ += ReadVarint(), 0, 0, 0, 0};
+  switch (op.kind) {
+    case TraceOp::Kind::Malloc:
+      op.size = ReadVarint();
+      op.id = ReadVarint();
+      break;
+    case TraceOp::Kind::Calloc:
+    case TraceOp::Kind::AlignedMalloc:
+      op.num = ReadVarint();
+      op.size = ReadVarint();
+      op.id = ReadVarint();
+      break;
+    case TraceOp::Kind::Realloc:
+      op.old_id = ReadVarint();
+      op.size = ReadVarint();
+      op.id = ReadVarint();
+      break;
+    case TraceOp::Kind::Free:
+      op.id = ReadVarint();
+      break;
+    case TraceOp::Kind::Defragmentation:
+      break;
+  }
+  return true;
+}
+
+std::uint64_t TraceReader::ReadVarint() {
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    auto byte = in_.get();
+    if (byte == std::ifstream::traits_type::eof()) {
+      throw std::runtime_error("Truncated trace");
+    }
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+  throw std::runtime_error("Corrupted trace");
+}
+
+}  // namespace s21
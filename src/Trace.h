@@ -0,0 +1,96 @@
+#ifndef MEMORY_TRACE_H
+#define MEMORY_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace s21 {
+// One recorded call. Blocks are named by ids given out in allocation order;
+// id 0 stands for a null pointer or a block allocated before recording.
+struct TraceOp {
+  enum class Kind : std::uint8_t {
+    Malloc,
+    Calloc,
+    Realloc,
+    Free,
+    Defragmentation,
+    AlignedMalloc,
+  };
+
+  Kind kind;
+  std::uint64_t time;  // nanoseconds since the start of the recording
+  std::uint64_t id;    // block returned, or freed for Free
+  std::uint64_t old_id;
+  std::uint64_t num;  // element count, or alignment for AlignedMalloc
+  std::uint64_t size;
+};
+
+// Writes a trace file: a magic string, the heap size and then one record
+// per call. Each record is the kind byte followed by LEB128 varints: the
+// time since the previous record and the operands of the call.
+class TraceWriter {
+ public:
+  TraceWriter(const std::string& path, std::size_t heap_size);
+
+  void Malloc(std::size_t size, const void* result);
+  void Calloc(std::size_t num, std::size_t size, const void* result);
+  void AlignedMalloc(std::size_t alignment, std::size_t size,
+                     const void* result);
+  void Free(const void* ptr);
+  void Defragmentation();
+  // Keeps the id of a block that defragmentation moved.
+  void Moved(const void* from, const void* to);
+  // Calls realloc under the writer lock, so that no other thread can get
+  // the old address and record it before this call is recorded.
+  template <class Function>
+  void* Realloc(void* ptr, std::size_t size, Function realloc);
+
+ private:
+  std::uint64_t NewId(const void* result);
+  std::uint64_t FindId(const void* ptr) const;
+  std::uint64_t TakeId(const void* ptr);
+  void Append(const TraceOp& op);
+  void WriteVarint(std::uint64_t value);
+
+  std::mutex mutex_;
+  std::ofstream out_;
+  std::chrono::steady_clock::time_point start_;
+  std::uint64_t last_time_ = 0;
+  std::uint64_t next_id_ = 1;
+  std::unordered_map<const void*, std::uint64_t> ids_;
+};
+
+class TraceReader {
+ public:
+  explicit TraceReader(const std::string& path);
+
+  std::size_t HeapSize() const noexcept;
+  bool Next(TraceOp& op);
+
+ private:
+  std::uint64_t ReadVarint();
+
+  std::ifstream in_;
+  std::size_t heap_size_ = 0;
+  std::uint64_t time_ = 0;
+};
+
+template <class Function>
+void* TraceWriter::Realloc(void* ptr, std::size_t size, Function realloc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto result = realloc();
+  TraceOp op{TraceOp::Kind::Realloc, 0, 0, 0, 0, size};
+  // A failed realloc leaves the old block in place under its old id.
+  op.old_id = result ? TakeId(ptr) : FindId(ptr);
+  op.id = NewId(result);
+  Append(op);
+  return result;
+}
+
+}  // namespace s21
+
+#endif  // MEMORY_TRACE_H
@@ -0,0 +1,175 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+#include "../Heap.h"
+
+namespace {
+
+using s21::Heap;
+
+constexpr std::size_t heap_size = 16 * 1024 * 1024;
+constexpr std::size_t live_blocks = 256;
+
+enum Policy : int64_t { FirstFit, SegregatedFit, Slabs, NextFit, BestFit };
+
+void *Allocate(Heap &heap, Policy policy, std::size_t size) {
+  return policy == SegregatedFit || policy == Slabs ? heap.MallocOnlyFree(size)
+                                                   : heap.Malloc(size);
+}
+
+std::unique_ptr<Heap> CreateHeap(benchmark::State &state, Policy policy) {
+  constexpr const char *names[] = {"first fit", "segregated fit", "slabs",
+                                   "next fit", "best fit"};
+  state.SetLabel(names[policy]);
+  auto heap = Heap::Create(heap_size);
+  heap->SetSlabs(policy == Slabs);
+  if (policy == NextFit) heap->SetPlacement(Heap::Placement::NextFit);
+  if (policy == BestFit) heap->SetPlacement(Heap::Placement::BestFit);
+  return heap;
+}
+
+// Frees the oldest of a window of live blocks before every allocation, so
+// the heap holds a steady amount of fragmented memory.
+void BM_MallocFree(benchmark::State &state) {
+  auto size = static_cast<std::size_t>(state.range(0));
+  auto policy = static_cast<Policy>(state.range(1));
+  auto heap = CreateHeap(state, policy);
+  std::vector<void *> blocks(live_blocks, nullptr);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    auto &block = blocks[i++ % live_blocks];
+    heap->Free(block);
+    block = Allocate(*heap, policy, size);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MallocFree)
+    ->ArgsProduct(
+        {{8, 64, 512, 4096}, {FirstFit, NextFit, SegregatedFit, Slabs}});
+
+void BM_ReallocGrowth(benchmark::State &state) {
+  constexpr std::size_t final_size = 64 * 1024;
+  auto step = static_cast<std::size_t>(state.range(0));
+  auto policy = static_cast<Policy>(state.range(1));
+  auto heap = CreateHeap(state, policy);
+  for (auto _ : state) {
+    void *block = nullptr;
+    for (std::size_t size = step; size <= final_size; size += step) {
+      block = policy == FirstFit ? heap->Realloc(block, size)
+                                 : heap->ReallocOnlyFree(block, size);
+    }
+    heap->Free(block);
+  }
+  state.SetItemsProcessed(state.iterations() * (final_size / step));
+}
+BENCHMARK(BM_ReallocGrowth)
+    ->ArgsProduct({{16, 256, 4096}, {FirstFit, SegregatedFit}});
+
+void BM_Calloc(benchmark::State &state) {
+  auto size = static_cast<std::size_t>(state.range(0));
+  auto policy = static_cast<Policy>(state.range(1));
+  auto heap = CreateHeap(state, policy);
+  for (auto _ : state) {
+    auto block = policy == FirstFit ? heap->Calloc(1, size)
+                                    : heap->CallocOnlyFree(1, size);
+    heap->Free(block);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_Calloc)->ArgsProduct(
+    {{64, 4096, 64 * 1024, 1024 * 1024}, {FirstFit, SegregatedFit}});
+
+// A request's worth of same-size blocks, allocated and freed together
+// either one by one or as a batch.
+void BM_Batch(benchmark::State &state) {
+  constexpr std::size_t size = 48;
+  auto count = static_cast<std::size_t>(state.range(0));
+  auto batched = state.range(1) != 0;
+  state.SetLabel(batched ? "batch" : "one by one");
+  auto heap = Heap::Create(heap_size);
+  std::vector<void *> blocks(count);
+  for (auto _ : state) {
+    if (batched) {
+      heap->MallocBatch(size, count, blocks.data());
+      heap->FreeBatch(blocks.data(), count);
+    } else {
+      for (auto &block : blocks) block = heap->MallocOnlyFree(size);
+      for (auto block : blocks) heap->Free(block);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Batch)->ArgsProduct({{8, 64, 512}, {0, 1}});
+
+// Fills the given percentage of a heap with blocks of mixed sizes, frees
+// every second one and measures a full compaction.
+void BM_Defragmentation(benchmark::State &state) {
+  constexpr std::size_t defragmented_heap_size = 4 * 1024 * 1024;
+  auto fill = static_cast<std::size_t>(state.range(0));
+  std::size_t moved_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto heap = Heap::Create(defragmented_heap_size);
+    std::vector<void *> blocks;
+    std::size_t used = 0;
+    for (std::size_t i = 0; used < defragmented_heap_size * fill / 100; ++i) {
+      auto size = 16 + i * 40 % 1000;
+      blocks.push_back(heap->MallocOnlyFree(size));
+      if (!blocks.back()) break;
+      used += size;
+      if (i % 2) moved_bytes += size;
+    }
+    for (std::size_t i = 0; i < blocks.size(); i += 2) heap->Free(blocks[i]);
+    state.ResumeTiming();
+    heap->Defragmentation();
+    state.PauseTiming();
+    heap.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(moved_bytes));
+}
+BENCHMARK(BM_Defragmentation)
+    ->Arg(25)
+    ->Arg(50)
+    ->Arg(75)
+    ->Arg(95)
+    ->Unit(benchmark::kMicrosecond);
+
+// Mostly small requests with a tail of medium and large ones.
+void BM_MixedSizes(benchmark::State &state) {
+  auto policy = static_cast<Policy>(state.range(0));
+  auto heap = CreateHeap(state, policy);
+  std::mt19937 gen(42);
+  std::discrete_distribution<int> kind({70, 25, 5});
+  std::uniform_int_distribution<std::size_t> small(8, 128), medium(129, 4096),
+      large(4097, 64 * 1024);
+  std::vector<std::size_t> sizes(4096);
+  for (auto &size : sizes) {
+    auto k = kind(gen);
+    size = k == 0 ? small(gen) : k == 1 ? medium(gen) : large(gen);
+  }
+  std::vector<void *> blocks(live_blocks, nullptr);
+  std::size_t i = 0, bytes = 0;
+  for (auto _ : state) {
+    auto &block = blocks[i % live_blocks];
+    heap->Free(block);
+    auto size = sizes[i++ % sizes.size()];
+    block = Allocate(*heap, policy, size);
+    bytes += size;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_MixedSizes)
+    ->Arg(FirstFit)
+    ->Arg(NextFit)
+    ->Arg(BestFit)
+    ->Arg(SegregatedFit)
+    ->Arg(Slabs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
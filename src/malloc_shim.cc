@@ -0,0 +1,206 @@
+// The C allocation functions on top of s21::Heap, for LD_PRELOAD.
+//
+// The heap is a single mmap-ed chunk set up by the first call, sized by
+// S21_HEAP_SIZE (1 GiB by default) and committed page by page. The heap
+// places every block at the alignment of std::max_align_t, as malloc has
+// to, so slots of slabs, which are only aligned to a word, are not used.
+// Only larger alignments make aligned blocks. Whatever the
+// heap cannot serve and whatever it allocates for its own bookkeeping comes
+// from glibc, so a pointer is the heap's exactly when it lies in the chunk.
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "Heap.h"
+
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void __libc_free(void *ptr);
+void *__libc_calloc(std::size_t num, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+}
+
+namespace {
+
+using s21::Heap;
+
+constexpr std::size_t default_heap_size = std::size_t{1} << 30;
+constexpr std::size_t min_alignment = alignof(std::max_align_t);
+
+Heap *heap = nullptr;
+std::atomic<std::uintptr_t> heap_begin{0}, heap_end{0};
+std::once_flag bootstrapped;
+// Thread caches are left off: they are torn down at thread exit, outside
+// of the guard, so the heap would call back into itself under its lock.
+std::mutex mutex;
+std::size_t (*libc_usable_size)(void *) = nullptr;
+// Set while this thread is in the heap, whose own allocations go to glibc.
+thread_local bool in_heap = false;
+
+class Guard {
+ public:
+  Guard() noexcept { in_heap = true; }
+  ~Guard() { in_heap = false; }
+  Guard(const Guard &) = delete;
+  Guard &operator=(const Guard &) = delete;
+};
+
+void Bootstrap() noexcept {
+  Guard guard;
+  libc_usable_size = reinterpret_cast<std::size_t (*)(void *)>(
+      dlsym(RTLD_NEXT, "malloc_usable_size"));
+  auto size = default_heap_size;
+  if (auto env = std::getenv("S21_HEAP_SIZE")) {
+    size = std::strtoull(env, nullptr, 10);
+  }
+  try {
+    auto created = Heap::Create(size, Heap::Storage::Mmap);
+    created->SetMinAlignment(min_alignment);
+    auto begin = reinterpret_cast<std::uintptr_t>(created->GetFirstHeader());
+    heap = created.release();
+    heap_begin = begin;
+    heap_end = begin + heap->Capacity();
+  } catch (...) {
+    // Everything is served by glibc.
+  }
+}
+
+// The heap, or null while this thread is inside it.
+Heap *Instance() noexcept {
+  if (in_heap) return nullptr;
+  std::call_once(bootstrapped, Bootstrap);
+  return heap;
+}
+
+bool Owns(const void *ptr) noexcept {
+  auto address = reinterpret_cast<std::uintptr_t>(ptr);
+  return address >= heap_begin.load(std::memory_order_relaxed) &&
+         address < heap_end.load(std::memory_order_relaxed);
+}
+
+// Called with a pointer the heap rejected, as glibc does for a bad free.
+[[noreturn]] void Abort() noexcept {
+  static const char message[] = "s21_malloc: invalid pointer\n";
+  std::fwrite(message, 1, sizeof(message) - 1, stderr);
+  std::abort();
+}
+
+}  // namespace
+
+extern "C" {
+
+void *malloc(std::size_t size) noexcept {
+  if (auto heap = Instance()) {
+    Guard guard;
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+      if (auto ptr = heap->MallocOnlyFree(size)) return ptr;
+    } catch (...) {
+    }
+  }
+  return __libc_malloc(size);
+}
+
+void free(void *ptr) noexcept {
+  if (!Owns(ptr)) return __libc_free(ptr);
+  Guard guard;
+  std::lock_guard<std::mutex> lock(mutex);
+  try {
+    heap->Free(ptr);
+  } catch (...) {
+    Abort();
+  }
+}
+
+void *calloc(std::size_t num, std::size_t size) noexcept {
+  if (size && num > SIZE_MAX / size) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  if (auto heap = Instance()) {
+    Guard guard;
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+      if (auto ptr = heap->CallocOnlyFree(num, size)) return ptr;
+    } catch (...) {
+    }
+  }
+  return __libc_calloc(num, size);
+}
+
+void *realloc(void *ptr, std::size_t size) noexcept {
+  if (!ptr) return malloc(size);
+  if (!Owns(ptr)) return __libc_realloc(ptr, size);
+  if (!size) {
+    free(ptr);
+    return nullptr;
+  }
+  std::size_t old_size;
+  {
+    Guard guard;
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+      if (auto moved = heap->ReallocOnlyFree(ptr, size)) return moved;
+      old_size = heap->UsableSize(ptr);
+    } catch (...) {
+      Abort();
+    }
+  }
+  // The heap is full, so the block moves to glibc.
+  auto moved = __libc_malloc(size);
+  if (moved) {
+    std::memcpy(moved, ptr, std::min(old_size, size));
+    free(ptr);
+  }
+  return moved;
+}
+
+int posix_memalign(void **memptr, std::size_t alignment,
+                   std::size_t size) noexcept {
+  if (!alignment || alignment & (alignment - 1) ||
+      alignment % sizeof(void *)) {
+    return EINVAL;
+  }
+  if (size > SIZE_MAX - alignment) return ENOMEM;
+  void *ptr = nullptr;
+  if (auto heap = Instance()) {
+    Guard guard;
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+      ptr = alignment <= min_alignment ? heap->MallocOnlyFree(size)
+                                       : heap->AlignedMalloc(alignment, size);
+    } catch (...) {
+    }
+  }
+  if (!ptr) ptr = __libc_memalign(alignment, size);
+  if (!ptr) return ENOMEM;
+  *memptr = ptr;
+  return 0;
+}
+
+std::size_t malloc_usable_size(void *ptr) noexcept {
+  if (!ptr) return 0;
+  if (!Owns(ptr)) {
+    Instance();
+    return libc_usable_size ? libc_usable_size(ptr) : 0;
+  }
+  Guard guard;
+  std::lock_guard<std::mutex> lock(mutex);
+  try {
+    return heap->UsableSize(ptr);
+  } catch (...) {
+    Abort();
+  }
+}
+
+}  // extern "C"
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Heap.h"
+#include "Trace.h"
+
+namespace {
+
+struct Options {
+  std::string trace;
+  bool segregated = false;
+  bool slabs = false;
+  s21::Heap::Placement placement = s21::Heap::Placement::FirstFit;
+  bool coalescing = true;
+  std::size_t heap_size = 0;
+  double growth_factor = 2;
+  std::size_t max_size = 0;
+  s21::Heap::Storage storage = s21::Heap::Storage::New;
+};
+
+struct Block {
+  void *ptr;
+  std::size_t size;
+};
+
+constexpr std::size_t fragmentation_sample_period = 1024;
+
+void PrintUsage() {
+  std::cerr << "Usage: replay TRACE [options]\n"
+               "  --first-fit          s21_malloc and s21_realloc (default)\n"
+               "  --next-fit           s21_malloc placing blocks by next fit\n"
+               "  --best-fit           s21_malloc placing blocks by best fit\n"
+               "  --segregated         the _onlyfree functions\n"
+               "  --slabs              segregated fit with slabs\n"
+               "  --no-coalescing      keep freed neighbours apart\n"
+               "  --heap-size BYTES    initial heap size (default: recorded)\n"
+               "  --growth FACTOR MAX  let the heap grow up to MAX bytes\n"
+               "  --mmap               keep the heap in mmap-ed memory\n";
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--first-fit") {
+      options.segregated = false;
+    } else if (arg == "--next-fit") {
+      options.segregated = false;
+      options.placement = s21::Heap::Placement::NextFit;
+    } else if (arg == "--best-fit") {
+      options.segregated = false;
+      options.placement = s21::Heap::Placement::BestFit;
+    } else if (arg == "--segregated") {
+      options.segregated = true;
+    } else if (arg == "--slabs") {
+      options.segregated = options.slabs = true;
+    } else if (arg == "--no-coalescing") {
+      options.coalescing = false;
+    } else if (arg == "--heap-size" && i + 1 < argc) {
+      options.heap_size = std::stoull(argv[++i]);
+    } else if (arg == "--growth" && i + 2 < argc) {
+      options.growth_factor = std::stod(argv[++i]);
+      options.max_size = std::stoull(argv[++i]);
+    } else if (arg == "--mmap") {
+      options.storage = s21::Heap::Storage::Mmap;
+    } else if (options.trace.empty() && arg[0] != '-') {
+      options.trace = arg;
+    } else {
+      throw std::invalid_argument("Unknown option " + arg);
+    }
+  }
+  if (options.trace.empty()) throw std::invalid_argument("No trace given");
+  return options;
+}
+
+int Replay(const Options &options) {
+  s21::TraceReader reader(options.trace);
+  std::vector<s21::TraceOp> ops;
+  for (s21::TraceOp op; reader.Next(op);) ops.push_back(op);
+
+  // The recorded size is the heap's capacity, which includes the header of
+  // its first block.
+  auto heap_size = options.heap_size
+                       ? options.heap_size
+                       : reader.HeapSize() - sizeof(s21::Heap::Header);
+  auto heap = s21::Heap::Create(heap_size, options.storage);
+  heap->SetCoalescing(options.coalescing);
+  heap->SetSlabs(options.slabs);
+  heap->SetPlacement(options.placement);
+  if (options.max_size) {
+    heap->SetGrowth(options.growth_factor, options.max_size);
+  }
+
+  std::unordered_map<std::uint64_t, Block> blocks;
+  std::size_t live_bytes = 0, peak_bytes = 0, peak_capacity = 0;
+  std::size_t failed = 0, moved = 0, samples = 0;
+  double fragmentation_sum = 0;
+  std::chrono::nanoseconds elapsed{0};
+  auto forget = [&](std::uint64_t id) {
+    auto block = blocks.find(id);
+    if (block == blocks.end()) return static_cast<void *>(nullptr);
+    auto ptr = block->second.ptr;
+    live_bytes -= block->second.size;
+    blocks.erase(block);
+    return ptr;
+  };
+  auto keep = [&](std::uint64_t id, void *ptr, std::size_t size) {
+    if (!ptr) {
+      ++failed;
+      return;
+    }
+    if (id) blocks[id] = {ptr, size};
+    live_bytes += size;
+  };
+
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    const auto &op = ops[i];
+    auto start = std::chrono::steady_clock::now();
+    switch (op.kind) {
+      case s21::TraceOp::Kind::Malloc:
+        keep(op.id,
+             options.segregated ? heap->MallocOnlyFree(op.size)
+                                : heap->Malloc(op.size),
+             op.size);
+        break;
+      case s21::TraceOp::Kind::Calloc:
+        keep(op.id,
+             options.segregated ? heap->CallocOnlyFree(op.num, op.size)
+                                : heap->Calloc(op.num, op.size),
+             op.num * op.size);
+        break;
+      case s21::TraceOp::Kind::AlignedMalloc:
+        keep(op.id, heap->AlignedMalloc(op.num, op.size), op.size);
+        break;
+      case s21::TraceOp::Kind::Realloc: {
+        auto old = blocks.find(op.old_id);
+        auto old_ptr = old == blocks.end() ? nullptr : old->second.ptr;
+        auto ptr = options.segregated ? heap->ReallocOnlyFree(old_ptr, op.size)
+                                      : heap->Realloc(old_ptr, op.size);
+        if (ptr) forget(op.old_id);
+        keep(op.id, ptr, op.size);
+      } break;
+      case s21::TraceOp::Kind::Free:
+        heap->Free(forget(op.id));
+        break;
+      case s21::TraceOp::Kind::Defragmentation: {
+        // Compaction moves the blocks, so the ids are pointed at the new
+        // addresses and later ops still reach them.
+        std::unordered_map<void *, std::uint64_t> ids;
+        for (const auto &[id, block] : blocks) ids[block.ptr] = id;
+        heap->Defragmentation([&](void *from, void *to) {
+          auto id = ids.find(from);
+          if (id == ids.end()) return;
+          blocks[id->second].ptr = to;
+          ++moved;
+        });
+      } break;
+    }
+    elapsed += std::chrono::steady_clock::now() - start;
+    peak_bytes = std::max(peak_bytes, live_bytes);
+    peak_capacity = std::max(peak_capacity, heap->Capacity());
+    if (i % fragmentation_sample_period == 0) {
+      fragmentation_sum += heap->GetStats().external_fragmentation;
+      ++samples;
+    }
+  }
+
+  auto recorded = ops.empty() ? 0 : ops.back().time;
+  std::cout << "Operations: \t" << ops.size() << "\n"
+            << "Recorded time: \t" << recorded / 1000 << " us\n"
+            << "Replay time: \t" << elapsed.count() / 1000 << " us\n"
+            << "Per operation: \t"
+            << (ops.empty() ? 0 : elapsed.count() / ops.size()) << " ns\n"
+            << "Peak requested: \t" << peak_bytes << " bytes\n"
+            << "Peak heap: \t" << peak_capacity << " bytes\n"
+            << "Mean fragmentation: \t"
+            << (samples ? fragmentation_sum / samples : 0) << "\n"
+            << "Final fragmentation: \t"
+            << heap->GetStats().external_fragmentation << "\n"
+            << "Failed allocations: \t" << failed << "\n";
+  if (moved) {
+    std::cout << "Blocks moved by defragmentation: \t" << moved << "\n";
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  try {
+    return Replay(ParseOptions(argc, argv));
+  } catch (std::invalid_argument &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    PrintUsage();
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+  }
+  return 1;
+}
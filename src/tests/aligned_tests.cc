@@ -0,0 +1,139 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+namespace {
+bool IsAligned(const void *ptr, size_type alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+// Whether every block ends where the next header starts and points back.
+bool BlocksChained(const s21::Heap::Header *header) {
+  for (; header->next(); header = header->next()) {
+    if (header->next()->prev() != header ||
+        header->addr() + header->size() + header->alignment() !=
+            reinterpret_cast<const std::byte *>(header->next())) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST_F(MemoryTests, AlignedAllocPlacesBlocks) {
+  s21_init(64 * 1024);
+  std::vector<void *> blocks;
+  for (size_type alignment : {8, 16, 32, 64, 4096}) {
+    for (size_type size : {1, 24, 100}) {
+      auto ptr = s21_aligned_alloc(alignment, size);
+      ASSERT_TRUE(ptr != nullptr);
+      EXPECT_TRUE(IsAligned(ptr, alignment));
+      blocks.push_back(ptr);
+    }
+  }
+  for (auto ptr : blocks) s21_free(ptr);
+  EXPECT_FALSE(s21_get_first_header()->state());
+  EXPECT_TRUE(s21_get_first_header()->next() == nullptr);
+}
+
+TEST_F(MemoryTests, AlignedAllocReusesPadding) {
+  auto heap = s21::Heap::Create(64 * 1024, s21::Heap::Storage::Mmap);
+  auto aligned = heap->AlignedMalloc(4096, 100);
+  auto padding = heap->GetFirstHeader();
+  EXPECT_FALSE(padding->state());
+  EXPECT_EQ(padding->next()->addr(), aligned);
+  auto small = heap->Malloc(num_elements);
+  EXPECT_LT(small, aligned);
+  EXPECT_EQ(heap->GetStats().used_blocks, 2);
+}
+
+TEST_F(MemoryTests, AlignedAllocFitsTightHeap) {
+  // The block only fits at the address the alignment gives it, not at the
+  // worst one.
+  auto heap = s21::Heap::Create(1024, s21::Heap::Storage::Mmap);
+  auto ptr = heap->AlignedMalloc(256, 760);
+  ASSERT_TRUE(ptr != nullptr);
+  EXPECT_TRUE(IsAligned(ptr, 256));
+  EXPECT_EQ(heap->AlignedMalloc(256, 1024), nullptr);
+}
+
+TEST_F(MemoryTests, EmptyAlignedBlockFitsFullHeap) {
+  for (size_type hole = 40; hole <= 160; hole += 8) {
+    auto heap = s21::Heap::Create(4096);
+    heap->Malloc(0);
+    auto gap = heap->Malloc(hole);
+    while (heap->Malloc(sizeof(void *))) {
+    }
+    heap->Free(gap);
+    auto ptr = heap->AlignedMalloc(64, 0);
+    if (ptr) {
+      EXPECT_TRUE(IsAligned(ptr, 64));
+      auto header = heap->GetFirstHeader();
+      while (header->addr() != ptr) header = header->next();
+      EXPECT_GE(header->size() + header->alignment(), sizeof(void *)) << hole;
+      heap->Free(ptr);
+    }
+    EXPECT_TRUE(BlocksChained(heap->GetFirstHeader())) << hole;
+  }
+}
+
+TEST_F(MemoryTests, MinAlignmentPlacesEveryBlock) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetMinAlignment(16);
+  std::vector<void *> blocks;
+  for (size_type i = 0; i < 300; ++i) {
+    auto ptr = i % 3 ? heap->MallocOnlyFree(i % 50) : heap->Calloc(1, i);
+    ASSERT_TRUE(ptr != nullptr);
+    EXPECT_TRUE(IsAligned(ptr, 16)) << i;
+    blocks.push_back(ptr);
+    if (i % 4 == 0) {
+      heap->Free(blocks[i / 2]);
+      blocks[i / 2] = heap->Realloc(nullptr, i % 40);
+    }
+  }
+  for (auto &ptr : blocks) {
+    ptr = heap->ReallocOnlyFree(ptr, 72);
+    EXPECT_TRUE(IsAligned(ptr, 16));
+  }
+  for (auto header = heap->GetFirstHeader(); header; header = header->next()) {
+    EXPECT_TRUE(IsAligned(header->addr(), 16));
+    EXPECT_FALSE(header->aligned());
+  }
+  EXPECT_TRUE(BlocksChained(heap->GetFirstHeader()));
+  EXPECT_ANY_THROW(heap->SetMinAlignment(8));
+  for (auto ptr : blocks) heap->Free(ptr);
+  EXPECT_NO_THROW(heap->SetMinAlignment(8));
+  EXPECT_ANY_THROW(heap->SetMinAlignment(32));
+}
+
+TEST_F(MemoryTests, AlignedAllocRejectsAlignment) {
+  s21_init(1024);
+  EXPECT_ANY_THROW(s21_aligned_alloc(0, int_size));
+  EXPECT_ANY_THROW(s21_aligned_alloc(48, int_size));
+}
+
+TEST_F(MemoryTests, DefragmentationKeepsAlignment) {
+  s21_init(64 * 1024);
+  auto x = s21_malloc(100);
+  auto y = s21_aligned_alloc(256, 100);
+  auto z = s21_aligned_alloc(64, 40);
+  std::memset(y, 1, 100);
+  std::memset(z, 2, 40);
+  s21_free(x);
+  y = s21_realloc(y, 104);
+  s21_defragmentation();
+  EXPECT_TRUE(IsAligned(y, 256));
+  EXPECT_TRUE(IsAligned(z, 64));
+  EXPECT_EQ(static_cast<char *>(y)[99], 1);
+  EXPECT_EQ(static_cast<char *>(z)[39], 2);
+  s21_free(y);
+  s21_free(z);
+  s21_defragmentation();
+  EXPECT_TRUE(s21_get_first_header()->next() == nullptr);
+}
+
+}  // namespace Test
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../HeapAllocator.h"
+#include "test_core.h"
+
+namespace Test {
+
+namespace {
+struct alignas(64) Line {
+  char bytes[64];
+};
+}  // namespace
+
+TEST_F(MemoryTests, AllocatorHoldsContainers) {
+  auto heap = s21::Heap::Create(1024 * 1024);
+  s21::HeapAllocator<int> allocator(*heap);
+  std::vector<int, s21::HeapAllocator<int>> vector(allocator);
+  for (int i = 0; i < 10000; ++i) vector.push_back(i);
+  using Pair = std::pair<const int, int>;
+  std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                     s21::HeapAllocator<Pair>>
+      map(16, std::hash<int>(), std::equal_to<int>(), allocator);
+  for (int i = 0; i < 1000; ++i) map[i] = vector[i * 10];
+  using String =
+      std::basic_string<char, std::char_traits<char>, s21::HeapAllocator<char>>;
+  String string("a string too long for the small string buffer", allocator);
+  EXPECT_EQ(map[999], 9990);
+  EXPECT_EQ(string.size(), 45);
+  EXPECT_EQ(heap->GetStats().used_blocks, map.size() + 3);
+}
+
+TEST_F(MemoryTests, AllocatorGivesMemoryBack) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  {
+    std::vector<double, s21::HeapAllocator<double>> vector{
+        s21::HeapAllocator<double>(*heap)};
+    vector.resize(1000);
+  }
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+  EXPECT_FALSE(heap->GetFirstHeader()->state());
+}
+
+TEST_F(MemoryTests, AllocatorAlignsOverAlignedTypes) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  s21::HeapAllocator<Line> allocator(*heap);
+  std::vector<Line *> lines;
+  for (int i = 0; i < 16; ++i) {
+    lines.push_back(allocator.allocate(i + 1));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(lines.back()) % alignof(Line),
+              0);
+  }
+  for (int i = 0; i < 16; ++i) allocator.deallocate(lines[i], i + 1);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+TEST_F(MemoryTests, AlignedBlocksSkipThreadCaches) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetConcurrent(true);
+  s21::HeapAllocator<Line> allocator(*heap);
+  auto lines = allocator.allocate(3);
+  auto aligned = heap->AlignedMalloc(64, 32);
+  allocator.deallocate(lines, 3);
+  heap->Free(aligned);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+  heap->SetConcurrent(false);
+}
+
+TEST_F(MemoryTests, AllocatorThrowsWhenFull) {
+  auto heap = s21::Heap::Create(1024);
+  s21::HeapAllocator<int> allocator(*heap);
+  EXPECT_THROW(allocator.allocate(1024), std::bad_alloc);
+  EXPECT_THROW(allocator.allocate(SIZE_MAX / 2), std::bad_array_new_length);
+  s21::HeapAllocator<char> other(*s21::Heap::Create(1024));
+  EXPECT_TRUE(allocator == s21::HeapAllocator<char>(allocator));
+  EXPECT_TRUE(allocator != other);
+}
+
+TEST_F(MemoryTests, ResourceRejectsHugeSizes) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetGrowth(2, SIZE_MAX);
+  EXPECT_EQ(heap->AlignedMalloc(64, SIZE_MAX - 40), nullptr);
+  EXPECT_EQ(heap->AlignedMalloc(std::size_t{1} << 63, 64), nullptr);
+  s21::HeapResource resource(*heap);
+  std::size_t huge = SIZE_MAX - 40;
+  EXPECT_THROW(static_cast<void>(resource.allocate(huge, 64)), std::bad_alloc);
+  s21::HeapAllocator<Line> allocator(*heap);
+  EXPECT_THROW(allocator.allocate(SIZE_MAX / sizeof(Line)), std::bad_alloc);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+  EXPECT_EQ(heap->GetStats().free_blocks, 1);
+}
+
+TEST_F(MemoryTests, ResourceHoldsPmrContainers) {
+  auto heap = s21::Heap::Create(1024 * 1024);
+  s21::HeapResource resource(*heap);
+  {
+    std::pmr::vector<std::pmr::string> strings(&resource);
+    for (int i = 0; i < 100; ++i) {
+      strings.emplace_back(std::to_string(i) +
+                           " is a string that does not fit in place");
+    }
+    std::pmr::map<int, Line> lines(&resource);
+    lines[1].bytes[0] = 'x';
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(&lines[1]) % alignof(Line), 0);
+    EXPECT_EQ(strings[42].substr(0, 2), "42");
+    EXPECT_GT(heap->GetStats().used_blocks, 100);
+  }
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+  EXPECT_TRUE(resource.is_equal(s21::HeapResource(*heap)));
+  EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+}  // namespace Test
@@ -0,0 +1,60 @@
+#include <future>
+#include <thread>
+
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, ArenasAreIndependent) {
+  auto first = s21::Heap::Create(1024);
+  auto second = s21::Heap::Create(256);
+  auto x = first->Malloc(512);
+  auto y = second->Malloc(int_size);
+  EXPECT_TRUE(x != nullptr);
+  EXPECT_TRUE(y != nullptr);
+  EXPECT_EQ(second->Malloc(512), nullptr);
+  first->Free(x);
+  EXPECT_FALSE(first->GetFirstHeader()->state());
+  EXPECT_TRUE(second->GetFirstHeader()->state());
+}
+
+TEST_F(MemoryTests, ArenaDoesNotTouchDefaultHeap) {
+  s21_init(64);
+  auto x = s21_malloc(int_size);
+  {
+    auto arena = s21::Heap::Create(64);
+    arena->Free(arena->Malloc(int_size));
+    arena->Defragmentation();
+  }
+  EXPECT_EQ(s21_get_first_header()->addr(), x);
+  EXPECT_TRUE(s21_get_first_header()->state());
+}
+
+TEST_F(MemoryTests, ArenaSizeTooSmall) {
+  EXPECT_ANY_THROW(s21::Heap::Create(0));
+  EXPECT_ANY_THROW(s21::Heap::Create(header_size));
+}
+
+TEST_F(MemoryTests, ArenaDestroyedBeforeThreadCache) {
+  auto arena = s21::Heap::Create(1024 * 1024);
+  arena->SetConcurrent(true);
+  std::promise<void> allocated, destroyed;
+  std::thread worker([&] {
+    arena->Free(arena->Malloc(int_size));
+    allocated.set_value();
+    destroyed.get_future().wait();
+  });
+  allocated.get_future().wait();
+  arena.reset();
+  destroyed.set_value();
+  worker.join();
+
+  auto next_arena = s21::Heap::Create(1024 * 1024);
+  next_arena->SetConcurrent(true);
+  next_arena->Free(next_arena->Malloc(int_size));
+  next_arena->SetConcurrent(false);
+  EXPECT_FALSE(next_arena->GetFirstHeader()->state());
+  EXPECT_TRUE(next_arena->GetFirstHeader()->next() == nullptr);
+}
+
+}  // namespace Test
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, MallocBatchCarvesNeighbours) {
+  s21_init(64 * 1024);
+  std::vector<void *> blocks(num_elements);
+  EXPECT_EQ(s21_malloc_batch(20, blocks.size(), blocks.data()),
+            blocks.size());
+  for (std::size_t i = 1; i < blocks.size(); ++i) {
+    auto distance =
+        static_cast<char *>(blocks[i]) - static_cast<char *>(blocks[i - 1]);
+    EXPECT_EQ(distance, header_size + 24);
+  }
+  auto stats = s21_get_stats();
+  EXPECT_EQ(stats.used_blocks, blocks.size());
+  EXPECT_EQ(stats.free_blocks, 1);
+  EXPECT_EQ(stats.allocations, blocks.size());
+}
+
+TEST_F(MemoryTests, MallocBatchStopsWhenFull) {
+  s21_init(1024);
+  std::vector<void *> blocks(100, nullptr);
+  auto done = s21_malloc_batch(100, blocks.size(), blocks.data());
+  EXPECT_EQ(done, 1024 / (header_size + 104));
+  EXPECT_EQ(s21_malloc(100), nullptr);
+  s21_free_batch(blocks.data(), done);
+  EXPECT_FALSE(s21_get_first_header()->state());
+  EXPECT_TRUE(s21_get_first_header()->next() == nullptr);
+}
+
+TEST_F(MemoryTests, MallocBatchFillsHoles) {
+  s21_init(4096);
+  std::vector<void *> blocks;
+  while (auto ptr = s21_malloc_onlyfree(40)) blocks.push_back(ptr);
+  for (std::size_t i = 0; i < blocks.size(); i += 4) s21_free(blocks[i]);
+  auto holes = (blocks.size() + 3) / 4;
+  std::vector<void *> batch(holes + 1);
+  EXPECT_EQ(s21_malloc_batch(40, batch.size(), batch.data()), holes);
+  std::sort(batch.begin(), batch.begin() + holes);
+  for (std::size_t i = 0; i < holes; ++i) EXPECT_EQ(batch[i], blocks[i * 4]);
+}
+
+TEST_F(MemoryTests, FreeBatchJoinsNeighbours) {
+  s21_init(64 * 1024);
+  s21_set_coalescing(false);
+  std::vector<void *> blocks(num_elements);
+  s21_malloc_batch(32, blocks.size(), blocks.data());
+  std::shuffle(blocks.begin(), blocks.end(), std::mt19937(21));
+  blocks.push_back(nullptr);
+  s21_free_batch(blocks.data(), blocks.size());
+  auto stats = s21_get_stats();
+  EXPECT_EQ(stats.used_blocks, 0);
+  EXPECT_EQ(stats.free_blocks, 2);
+  EXPECT_EQ(stats.frees, num_elements);
+  s21_set_coalescing(true);
+}
+
+TEST_F(MemoryTests, FreeBatchRejectsRepeatedPointer) {
+  s21_init(1024);
+  void *blocks[2];
+  blocks[0] = blocks[1] = s21_malloc(16);
+  EXPECT_ANY_THROW(s21_free_batch(blocks, 2));
+  s21_free(blocks[0]);
+}
+
+TEST_F(SlabTests, FreeBatchRejectsRepeatedSlot) {
+  void *blocks[3];
+  blocks[0] = s21_malloc(16);
+  blocks[1] = s21_malloc(16);
+  blocks[2] = blocks[0];
+  EXPECT_ANY_THROW(s21_free_batch(blocks, 3));
+  auto stats = s21_get_stats();
+  EXPECT_EQ(stats.frees, 0);
+  s21_free_batch(blocks, 2);
+  EXPECT_EQ(s21_get_stats().frees, 2);
+}
+
+TEST_F(MemoryTests, MallocBatchRejectsHugeSizes) {
+  s21_init(1024);
+  void *blocks[2] = {nullptr, nullptr};
+  EXPECT_EQ(s21_malloc_batch(SIZE_MAX - 4, 2, blocks), 0);
+  EXPECT_EQ(s21_malloc_batch(SIZE_MAX / 2, 2, blocks), 0);
+  EXPECT_EQ(s21_malloc_batch(SIZE_MAX / 8, 2, blocks), 0);
+  EXPECT_TRUE(blocks[0] == nullptr && blocks[1] == nullptr);
+  EXPECT_EQ(s21_get_stats().used_blocks, 0);
+}
+
+}  // namespace Test
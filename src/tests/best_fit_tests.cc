@@ -0,0 +1,60 @@
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, BestFitTakesTightestBlock) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto large = heap->Malloc(512);
+  heap->Malloc(8);
+  auto small = heap->Malloc(64);
+  heap->Malloc(8);
+  auto middle = heap->Malloc(128);
+  heap->Malloc(8);
+  heap->Free(large);
+  heap->Free(small);
+  heap->Free(middle);
+  heap->SetBestFit(true);
+  EXPECT_EQ(heap->Malloc(100), middle);
+  EXPECT_EQ(heap->Malloc(60), small);
+  EXPECT_EQ(heap->Malloc(500), large);
+}
+
+TEST_F(MemoryTests, FirstFitTakesLowestBlock) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto large = heap->Malloc(512);
+  heap->Malloc(8);
+  auto small = heap->Malloc(64);
+  heap->Malloc(8);
+  heap->Free(large);
+  heap->Free(small);
+  heap->SetBestFit(true);
+  heap->SetBestFit(false);
+  EXPECT_EQ(heap->Malloc(60), large);
+}
+
+TEST_F(MemoryTests, BestFitFollowsFreesAndMerges) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetBestFit(true);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 6; ++i) blocks.push_back(heap->Malloc(64));
+  heap->Free(blocks[1]);
+  heap->Free(blocks[2]);
+  heap->Free(blocks[4]);
+  EXPECT_EQ(heap->Malloc(64), blocks[4]);
+  EXPECT_EQ(heap->Malloc(64 + header_size + 64), blocks[1]);
+  heap->Defragmentation();
+  EXPECT_NE(heap->Malloc(1024), nullptr);
+}
+
+TEST_F(MemoryTests, BestFitGrowsHeap) {
+  auto heap = s21::Heap::Create(1024);
+  heap->SetGrowth(2, 64 * 1024);
+  heap->SetBestFit(true);
+  auto ptr = heap->Calloc(1, 4096);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_GT(heap->Capacity(), 4096);
+}
+
+}  // namespace Test
@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../BuddyHeap.h"
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(BuddyTests, MallocKeepsValues) {
+  std::vector<int *> blocks;
+  for (size_type i = 0; i < num_elements; ++i) {
+    blocks.push_back(static_cast<int *>(s21_malloc(int_size * (i + 1))));
+    ASSERT_NE(blocks.back(), nullptr);
+    for (size_type j = 0; j <= i; ++j) blocks.back()[j] = static_cast<int>(i);
+  }
+  for (size_type i = 0; i < num_elements; ++i) {
+    for (size_type j = 0; j <= i; ++j) EXPECT_EQ(blocks[i][j], i);
+    s21_free(blocks[i]);
+  }
+}
+
+TEST_F(BuddyTests, BlocksAreAlignedToTheirSize) {
+  for (size_type size = 16; size <= 4096; size *= 2) {
+    auto ptr = s21_malloc(size);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % size, 0);
+  }
+  auto ptr = s21_aligned_alloc(1024, 10);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 1024, 0);
+}
+
+TEST_F(BuddyTests, BuddiesMergeBack) {
+  std::vector<void *> blocks;
+  while (auto ptr = s21_malloc(16)) blocks.push_back(ptr);
+  EXPECT_EQ(blocks.size(), heap_size / 16);
+  EXPECT_EQ(s21_malloc(heap_size), nullptr);
+  s21_free_batch(blocks.data(), blocks.size());
+  EXPECT_NE(s21_malloc(heap_size), nullptr);
+}
+
+TEST_F(BuddyTests, CallocClears) {
+  auto dirty = s21_malloc(1000);
+  std::memset(dirty, 0xAB, 1000);
+  s21_free(dirty);
+  auto ptr = static_cast<unsigned char *>(s21_calloc(10, 100));
+  for (int i = 0; i < 1000; ++i) EXPECT_EQ(ptr[i], 0);
+  EXPECT_EQ(s21_calloc(SIZE_MAX / 2, 3), nullptr);
+}
+
+TEST_F(BuddyTests, ReallocShrinksInPlaceAndGrowsByMoving) {
+  auto heap = s21::BuddyHeap::Create(4096);
+  auto ptr = static_cast<char *>(heap->Malloc(1024));
+  std::memset(ptr, 'x', 1024);
+  EXPECT_EQ(heap->Realloc(ptr, 100), ptr);
+  EXPECT_EQ(heap->UsableSize(ptr), 128);
+  EXPECT_EQ(heap->BytesInUse(), 128);
+  auto grown = static_cast<char *>(heap->Realloc(ptr, 2048));
+  ASSERT_NE(grown, nullptr);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(grown[i], 'x');
+  EXPECT_EQ(heap->BytesInUse(), 2048);
+  heap->Free(grown);
+  EXPECT_EQ(heap->Malloc(4096), static_cast<void *>(ptr));
+}
+
+TEST_F(BuddyTests, RejectsWrongPointers) {
+  auto ptr = static_cast<char *>(s21_malloc(64));
+  EXPECT_THROW(s21_free(ptr + 16), std::runtime_error);
+  int x = 0;
+  EXPECT_THROW(s21_free(&x), std::runtime_error);
+  s21_free(ptr);
+  EXPECT_THROW(s21_free(ptr), std::runtime_error);
+}
+
+TEST_F(BuddyTests, SizeIsRoundedUp) {
+  auto heap = s21::BuddyHeap::Create(3000);
+  EXPECT_EQ(heap->Capacity(), 4096);
+  EXPECT_EQ(heap->Malloc(5000), nullptr);
+  EXPECT_NE(heap->Malloc(4096), nullptr);
+}
+
+}  // namespace Test
@@ -0,0 +1,73 @@
+#include <cstdint>
+
+#include "../BumpArena.h"
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, BumpArenaAllocatesWithoutHeaders) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  s21::BumpArena arena(*heap, 4096);
+  auto first = static_cast<char *>(arena.Allocate(16));
+  for (int i = 1; i < 100; ++i) {
+    EXPECT_EQ(static_cast<char *>(arena.Allocate(16)), first + i * 16);
+  }
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.used_blocks, 1);
+  EXPECT_EQ(stats.allocations, 1);
+}
+
+TEST_F(MemoryTests, BumpArenaAligns) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  s21::BumpArena arena(*heap, 4096);
+  arena.Allocate(1, 1);
+  auto ptr = arena.Allocate(10, 256);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 256, 0);
+  ptr = arena.Allocate(3000, 1024);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 1024, 0);
+}
+
+TEST_F(MemoryTests, BumpArenaChainsAndReusesBlocks) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  s21::BumpArena arena(*heap, 1024);
+  auto first = arena.Allocate(512);
+  for (int i = 0; i < 10; ++i) arena.Allocate(512);
+  EXPECT_NE(arena.Allocate(5000), nullptr);
+  auto taken = heap->GetStats().allocations;
+  EXPECT_GT(taken, 1);
+  arena.Reset();
+  EXPECT_EQ(arena.Allocate(512), first);
+  for (int i = 0; i < 10; ++i) arena.Allocate(512);
+  arena.Allocate(5000);
+  EXPECT_EQ(heap->GetStats().allocations, taken);
+}
+
+TEST_F(MemoryTests, BumpArenaRewindsToMark) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  s21::BumpArena arena(*heap, 1024);
+  arena.Allocate(100);
+  auto mark = arena.GetMark();
+  auto ptr = arena.Allocate(100);
+  for (int i = 0; i < 20; ++i) arena.Allocate(200);
+  arena.Rewind(mark);
+  EXPECT_EQ(arena.Allocate(100), ptr);
+}
+
+TEST_F(MemoryTests, BumpArenaGivesBlocksBack) {
+  auto heap = s21::Heap::Create(16 * 1024);
+  {
+    s21::BumpArena arena(*heap, 1024);
+    while (arena.Allocate(256)) {
+    }
+    EXPECT_EQ(heap->Malloc(1024), nullptr);
+  }
+  EXPECT_FALSE(heap->GetFirstHeader()->state());
+  EXPECT_TRUE(heap->GetFirstHeader()->next() == nullptr);
+}
+
+TEST_F(MemoryTests, BumpArenaThrowsWithoutFirstBlock) {
+  auto heap = s21::Heap::Create(1024);
+  EXPECT_THROW(s21::BumpArena(*heap, 4096), std::bad_alloc);
+}
+
+}  // namespace Test
@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+bool AllZero(const void *ptr, std::size_t size) {
+  auto bytes = static_cast<const unsigned char *>(ptr);
+  for (std::size_t i = 0; i < size; ++i) {
+    if (bytes[i]) return false;
+  }
+  return true;
+}
+
+TEST_F(MemoryTests, CallocRejectsOverflow) {
+  auto heap = s21::Heap::Create(4096);
+  EXPECT_EQ(heap->Calloc(SIZE_MAX / 2, 3), nullptr);
+  EXPECT_EQ(heap->CallocOnlyFree(3, SIZE_MAX / 2), nullptr);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+TEST_F(MemoryTests, CallocClearsReusedMemory) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto dirty = heap->Malloc(1000);
+  std::memset(dirty, 0xAB, 1000);
+  heap->Free(dirty);
+  EXPECT_FALSE(heap->GetFirstHeader()->zeroed());
+  auto ptr = heap->Calloc(10, 100);
+  EXPECT_EQ(ptr, dirty);
+  EXPECT_TRUE(AllZero(ptr, 1000));
+}
+
+TEST_F(MemoryTests, FreshMemoryStaysZeroed) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  EXPECT_TRUE(heap->GetFirstHeader()->zeroed());
+  auto a = heap->CallocOnlyFree(100, 8);
+  EXPECT_TRUE(AllZero(a, 800));
+  auto tail = heap->GetFirstHeader()->next();
+  EXPECT_TRUE(tail->zeroed());
+  std::memset(a, 0xAB, 800);
+  heap->Free(a);
+  EXPECT_FALSE(heap->GetFirstHeader()->zeroed());
+}
+
+TEST_F(MemoryTests, LargeCallocIsCleared) {
+  auto heap = s21::Heap::Create(32 * 1024 * 1024);
+  auto size = 24 * 1024 * 1024 + 3;
+  auto dirty = heap->Malloc(size);
+  std::memset(dirty, 0xAB, size);
+  heap->Free(dirty);
+  auto ptr = heap->Calloc(1, size);
+  EXPECT_TRUE(AllZero(ptr, size));
+}
+
+TEST_F(MemoryTests, DefragmentationLeavesZeroedSpace) {
+  auto heap = s21::Heap::Create(1024 * 1024, s21::Heap::Storage::Mmap);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 400; ++i) {
+    blocks.push_back(heap->Malloc(1000));
+    std::memset(blocks.back(), 0xCD, 1000);
+  }
+  for (std::size_t i = 0; i < blocks.size(); i += 2) heap->Free(blocks[i]);
+  heap->Defragmentation();
+  auto header = heap->GetFirstHeader();
+  while (header->next()) header = header->next();
+  EXPECT_TRUE(header->zeroed());
+  auto ptr = heap->Calloc(1, header->size());
+  EXPECT_TRUE(AllZero(ptr, header->size()));
+}
+
+}  // namespace Test
@@ -0,0 +1,124 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+using namespace std::chrono_literals;
+
+TEST_F(MemoryTests, PinnedBlockStaysInPlace) {
+  auto heap = s21::Heap::Create(4096);
+  auto first = heap->MallocHandle(40);
+  auto second = heap->MallocHandle(40);
+  heap->FreeHandle(first);
+  auto data = heap->Pin(second);
+  EXPECT_EQ(heap->Compact(SIZE_MAX, 1s), 0);
+  heap->Defragmentation();
+  EXPECT_EQ(heap->Resolve(second), data);
+  heap->Unpin(second);
+  EXPECT_GT(heap->Compact(SIZE_MAX, 1s), 0);
+  EXPECT_NE(heap->Resolve(second), data);
+  EXPECT_EQ(heap->Pin(0), nullptr);
+}
+
+TEST_F(MemoryTests, CompactorReducesFragmentation) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  std::vector<s21::Heap::Handle> handles;
+  while (auto handle = heap->MallocHandle(100)) handles.push_back(handle);
+  for (std::size_t i = 0; i < handles.size(); i += 2) {
+    heap->FreeHandle(handles[i]);
+  }
+  ASSERT_GT(heap->GetStats().external_fragmentation, 0.5);
+  heap->StartCompactor(0.1, 1ms, 1024, 100us);
+  for (int i = 0; i < 1000 && heap->GetStats().external_fragmentation > 0.1;
+       ++i) {
+    std::this_thread::sleep_for(1ms);
+  }
+  heap->StopCompactor();
+  EXPECT_LE(heap->GetStats().external_fragmentation, 0.1);
+}
+
+TEST_F(MemoryTests, CompactorLeavesThreadCachesOff) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->StartCompactor(0.5, 1ms, 1024, 100us);
+  heap->Free(heap->Malloc(16));
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+  heap->StopCompactor();
+  heap->SetConcurrent(true);
+  heap->StartCompactor(0.5, 1ms, 1024, 100us);
+  heap->Free(heap->Malloc(16));
+  EXPECT_GT(heap->GetStats().used_blocks, 0);
+  heap->StopCompactor();
+  heap->SetConcurrent(false);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+TEST_F(ConcurrencyTests, PinnedReadsDuringCompaction) {
+  constexpr int blocks_per_thread = 64, rounds = 2000;
+  std::atomic<bool> failed{false};
+  s21_start_compactor(0, 1ms, 4096, 50us);
+  std::vector<std::thread> threads;
+  for (size_type t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&failed, t] {
+      std::vector<s21::Heap::Handle> handles(blocks_per_thread);
+      for (int i = 0; i < rounds; ++i) {
+        auto &handle = handles[i % blocks_per_thread];
+        if (handle) {
+          auto data = static_cast<unsigned char *>(s21_pin(handle));
+          if (data[0] != t || data[99] != t) failed = true;
+          s21_unpin(handle);
+          s21_free_handle(handle);
+        }
+        handle = s21_malloc_handle(100);
+        if (handle) std::memset(s21_pin(handle), static_cast<int>(t), 100);
+        if (handle) s21_unpin(handle);
+      }
+      for (auto handle : handles) s21_free_handle(handle);
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  s21_stop_compactor();
+  EXPECT_FALSE(failed);
+  EXPECT_EQ(s21_get_stats().used_blocks, 0);
+}
+
+TEST_F(ConcurrencyTests, CompactorLeavesDataOfOtherBlocksAlone) {
+  constexpr int rounds = 2000, threads_count = 4;
+  std::atomic<bool> failed{false};
+  s21_start_compactor(0, 1ms, 4096, 50us);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_count; ++t) {
+    threads.emplace_back([&failed, t] {
+      for (int i = 0; i < rounds; ++i) {
+        auto size = 8 + (i * 37 + t) % 300;
+        auto block = static_cast<unsigned char *>(s21_malloc(size));
+        auto zeroed = static_cast<unsigned char *>(s21_calloc(size, 2));
+        if (!block || !zeroed) continue;
+        std::memset(block, t, size);
+        if (zeroed[0] || zeroed[2 * size - 1]) failed = true;
+        std::memset(zeroed, t, 2 * size);
+        auto grown = static_cast<unsigned char *>(s21_realloc(block, 2 * size));
+        if (grown) block = grown;
+        if (block[0] != t || block[size - 1] != t) failed = true;
+        auto handle = s21_malloc_handle(size);
+        if (handle) {
+          std::memset(s21_pin(handle), t, size);
+          s21_unpin(handle);
+          s21_free_handle(handle);
+        }
+        s21_free(block);
+        s21_free(zeroed);
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  s21_stop_compactor();
+  EXPECT_FALSE(failed);
+  EXPECT_EQ(s21_get_stats().used_blocks, 0);
+}
+
+}  // namespace Test
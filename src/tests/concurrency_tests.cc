@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <thread>
+
+#include "test_core.h"
+
+namespace Test {
+
+void ExpectWholeHeapFree() {
+  auto header = s21_get_first_header();
+  EXPECT_FALSE(header->state());
+  EXPECT_TRUE(header->next() == nullptr);
+}
+
+TEST_F(ConcurrencyTests, MallocFreeFromManyThreads) {
+  auto work = [](unsigned char id) {
+    std::vector<std::pair<unsigned char *, size_type>> blocks;
+    for (size_type i = 0; i < 20'000; ++i) {
+      auto size = 1 + (i * 37 + id) % 512;
+      auto block = static_cast<unsigned char *>(s21_malloc(size));
+      ASSERT_TRUE(block != nullptr);
+      std::fill_n(block, size, id);
+      blocks.emplace_back(block, size);
+      if (blocks.size() > 32) {
+        auto [old_block, old_size] = blocks[i % blocks.size()];
+        for (size_type j = 0; j < old_size; ++j) ASSERT_EQ(old_block[j], id);
+        s21_free(old_block);
+        blocks.erase(blocks.begin() + i % blocks.size());
+      }
+    }
+    for (auto [block, size] : blocks) s21_free(block);
+  };
+
+  std::vector<std::thread> threads;
+  for (size_type i = 0; i < num_threads; ++i) {
+    threads.emplace_back(work, static_cast<unsigned char>(i + 1));
+  }
+  for (auto &thread : threads) thread.join();
+  s21_set_concurrent(false);
+  ExpectWholeHeapFree();
+}
+
+TEST_F(ConcurrencyTests, BlocksFreedByOtherThread) {
+  std::vector<void *> blocks(1'000, nullptr);
+  std::thread producer([&blocks] {
+    for (auto &block : blocks) block = s21_malloc(int_size);
+  });
+  producer.join();
+  std::thread consumer([&blocks] {
+    for (auto block : blocks) s21_free(block);
+  });
+  consumer.join();
+  ExpectWholeHeapFree();
+}
+
+TEST_F(ConcurrencyTests, DefragmentationFlushesThreadCaches) {
+  auto x = s21_malloc(int_size);
+  s21_free(x);
+  EXPECT_TRUE(s21_get_first_header()->state());
+  s21_defragmentation();
+  ExpectWholeHeapFree();
+}
+
+// A cached block may be handed out for a size up to its size class, which
+// reaches into its padding.
+TEST_F(ConcurrencyTests, ReallocKeepsWholeCachedBlock) {
+  for (size_type i = 0; i < 1000; ++i) {
+    auto size = 8 + i * 37 % 300;
+    auto block = static_cast<unsigned char *>(s21_malloc(size));
+    auto other = s21_calloc(size, 2);
+    std::fill_n(block, size, 1);
+    block = static_cast<unsigned char *>(s21_realloc(block, 2 * size));
+    ASSERT_TRUE(block != nullptr);
+    ASSERT_EQ(std::count(block, block + size, 1), size);
+    s21_free(block);
+    s21_free(other);
+  }
+}
+
+TEST_F(ConcurrencyTests, LargeBlocksBypassThreadCaches) {
+  auto x = s21_malloc(1024);
+  s21_free(x);
+  ExpectWholeHeapFree();
+}
+
+}  // namespace Test
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+using namespace std::chrono_literals;
+
+namespace {
+// Fills every other block with handles and frees the rest, leaving a hole
+// in front of each handle block.
+std::vector<s21::Heap::Handle> Fragment(s21::Heap &heap, size_type size) {
+  std::vector<s21::Heap::Handle> handles;
+  while (auto handle = heap.MallocHandle(size)) handles.push_back(handle);
+  std::vector<s21::Heap::Handle> kept;
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    if (i % 2) {
+      std::memset(heap.Resolve(handles[i]), static_cast<int>(i), size);
+      kept.push_back(handles[i]);
+    } else {
+      heap.FreeHandle(handles[i]);
+    }
+  }
+  return kept;
+}
+
+void ExpectContents(s21::Heap &heap,
+                    const std::vector<s21::Heap::Handle> &handles,
+                    size_type size) {
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    auto data = static_cast<unsigned char *>(heap.Resolve(handles[i]));
+    ASSERT_EQ(data[0], 2 * i + 1);
+    ASSERT_EQ(data[size - 1], 2 * i + 1);
+  }
+}
+}  // namespace
+
+TEST_F(MemoryTests, HandleOfHugeSizeFails) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetGrowth(2, SIZE_MAX);
+  EXPECT_EQ(heap->MallocHandle(SIZE_MAX - 4), 0);
+  EXPECT_EQ(heap->MallocHandle(SIZE_MAX - 64), 0);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+TEST_F(MemoryTests, HandleResolvesToData) {
+  auto heap = s21::Heap::Create(1024);
+  auto handle = heap->MallocHandle(num_elements);
+  ASSERT_NE(handle, 0);
+  EXPECT_TRUE(heap->Resolve(handle) != nullptr);
+  EXPECT_EQ(heap->Resolve(0), nullptr);
+  EXPECT_EQ(heap->MallocHandle(4096), 0);
+  heap->FreeHandle(handle);
+  heap->FreeHandle(0);
+  EXPECT_EQ(heap->Resolve(handle), nullptr);
+  EXPECT_FALSE(heap->GetFirstHeader()->state());
+  EXPECT_EQ(heap->MallocHandle(num_elements), handle);
+}
+
+TEST_F(MemoryTests, HandlesSurviveDefragmentation) {
+  auto heap = s21::Heap::Create(4096);
+  auto handles = Fragment(*heap, 40);
+  heap->Defragmentation();
+  ExpectContents(*heap, handles, 40);
+  EXPECT_EQ(heap->GetStats().free_blocks, 1);
+}
+
+TEST_F(MemoryTests, CompactMovesHandleBlocks) {
+  auto heap = s21::Heap::Create(4096);
+  auto handles = Fragment(*heap, 40);
+  EXPECT_GT(heap->GetStats().external_fragmentation, 0.5);
+  EXPECT_GT(heap->Compact(SIZE_MAX, 1s), 0);
+  ExpectContents(*heap, handles, 40);
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.free_blocks, 1);
+  EXPECT_EQ(stats.external_fragmentation, 0);
+  EXPECT_EQ(heap->Compact(SIZE_MAX, 1s), 0);
+}
+
+TEST_F(MemoryTests, CompactKeepsToByteBudget) {
+  auto heap = s21::Heap::Create(4096);
+  auto handles = Fragment(*heap, 40);
+  constexpr size_type budget = 200;
+  std::size_t calls = 0;
+  while (auto moved = heap->Compact(budget, 1s)) {
+    EXPECT_LE(moved, budget);
+    ++calls;
+  }
+  EXPECT_GT(calls, 1);
+  ExpectContents(*heap, handles, 40);
+  EXPECT_EQ(heap->GetStats().free_blocks, 1);
+}
+
+TEST_F(MemoryTests, CompactStopsAtDeadline) {
+  auto heap = s21::Heap::Create(4096);
+  Fragment(*heap, 40);
+  EXPECT_EQ(heap->Compact(SIZE_MAX, 0us), 0);
+  EXPECT_EQ(heap->Compact(0, 1s), 0);
+}
+
+TEST_F(MemoryTests, CompactLeavesPointersInPlace) {
+  auto heap = s21::Heap::Create(4096);
+  auto first = heap->MallocHandle(40);
+  auto pinned = heap->Malloc(40);
+  auto second = heap->MallocHandle(40);
+  auto data = heap->Resolve(second);
+  heap->FreeHandle(first);
+  EXPECT_EQ(heap->Compact(SIZE_MAX, 1s), 0);
+  EXPECT_FALSE(heap->GetFirstHeader()->state());
+  EXPECT_EQ(heap->GetFirstHeader()->next()->addr(), pinned);
+  EXPECT_EQ(heap->Resolve(second), data);
+}
+
+TEST_F(MemoryTests, CompactSpansChunks) {
+  s21_init(1024);
+  s21_set_growth(2, 16 * 1024);
+  std::vector<s21::Heap::Handle> handles;
+  for (int i = 0; i < 64; ++i) handles.push_back(s21_malloc_handle(100));
+  for (std::size_t i = 0; i < handles.size(); i += 2) {
+    s21_free_handle(handles[i]);
+  }
+  while (s21_compact(1024, 1s)) {
+  }
+  auto stats = s21_get_stats();
+  EXPECT_EQ(stats.used_blocks, handles.size() / 2);
+  // One free block is left at the end of each chunk.
+  EXPECT_LE(stats.free_blocks, 4);
+  s21_set_growth(2, 0);
+}
+
+}  // namespace Test
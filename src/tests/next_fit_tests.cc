@@ -0,0 +1,64 @@
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, NextFitResumesAfterLastBlock) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetPlacement(s21::Heap::Placement::NextFit);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 8; ++i) blocks.push_back(heap->Malloc(64));
+  heap->Free(blocks[1]);
+  EXPECT_GT(heap->Malloc(64), blocks[7]);
+  heap->SetPlacement(s21::Heap::Placement::FirstFit);
+  EXPECT_EQ(heap->Malloc(64), blocks[1]);
+}
+
+TEST_F(MemoryTests, NextFitWrapsAround) {
+  auto heap = s21::Heap::Create(1024);
+  heap->SetPlacement(s21::Heap::Placement::NextFit);
+  std::vector<void *> blocks;
+  while (auto ptr = heap->Malloc(64)) blocks.push_back(ptr);
+  heap->Free(blocks[1]);
+  heap->Free(blocks[5]);
+  EXPECT_EQ(heap->Malloc(64), blocks[1]);
+  EXPECT_EQ(heap->Malloc(64), blocks[5]);
+  heap->Free(blocks[0]);
+  heap->Free(blocks[6]);
+  EXPECT_EQ(heap->Malloc(64), blocks[6]);
+  EXPECT_EQ(heap->Malloc(64), blocks[0]);
+  EXPECT_EQ(heap->Malloc(64), nullptr);
+}
+
+TEST_F(MemoryTests, NextFitRoverSurvivesMerges) {
+  auto heap = s21::Heap::Create(1024);
+  heap->SetPlacement(s21::Heap::Placement::NextFit);
+  std::vector<void *> blocks;
+  while (auto ptr = heap->Malloc(64)) blocks.push_back(ptr);
+  heap->Free(blocks[4]);
+  EXPECT_EQ(heap->Malloc(64), blocks[4]);
+  // The rover's block is merged into the free block in front of it.
+  heap->Free(blocks[3]);
+  heap->Free(blocks[4]);
+  heap->Free(blocks[5]);
+  EXPECT_EQ(heap->Malloc(200), blocks[3]);
+  heap->Free(blocks[0]);
+  heap->Defragmentation();
+  EXPECT_NE(heap->Malloc(64), nullptr);
+}
+
+TEST_F(MemoryTests, NextFitFollowsGrowth) {
+  auto heap = s21::Heap::Create(1024);
+  heap->SetGrowth(2, 64 * 1024);
+  heap->SetPlacement(s21::Heap::Placement::NextFit);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 100; ++i) {
+    blocks.push_back(heap->Malloc(64));
+    ASSERT_NE(blocks.back(), nullptr);
+  }
+  for (auto block : blocks) heap->Free(block);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+}  // namespace Test
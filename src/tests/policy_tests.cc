@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+using namespace s21::policy;
+
+TEST_F(MemoryTests, PlacementPolicyIsChosenPerCall) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto large = heap->Malloc(512);
+  heap->Malloc(8);
+  auto small = heap->Malloc(64);
+  heap->Malloc(8);
+  heap->Free(large);
+  heap->Free(small);
+  EXPECT_EQ((heap->Allocate<BestFit, Unlocked>(60)), small);
+  heap->Free(small);
+  EXPECT_EQ((heap->Allocate<FirstFit, Unlocked>(60)), large);
+  EXPECT_LT(heap->Malloc(60), small);
+}
+
+TEST_F(MemoryTests, UncountedCallsLeaveCounters) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto ptr = heap->Allocate<SegregatedFit, Unlocked, Uncounted>(100);
+  ptr = heap->Reallocate<SegregatedFit, Unlocked, Uncounted>(ptr, 1000);
+  heap->Deallocate<Unlocked, Uncounted>(ptr);
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.allocations, 0);
+  EXPECT_EQ(stats.reallocations, 0);
+  EXPECT_EQ(stats.frees, 0);
+  EXPECT_EQ(stats.used_blocks, 0);
+}
+
+TEST_F(MemoryTests, StatsCatchUpAfterUncountedCalls) {
+  auto counted = s21::Heap::Create(64 * 1024);
+  auto uncounted = s21::Heap::Create(64 * 1024);
+  std::vector<void *> blocks, others;
+  for (std::size_t i = 0; i < 60; ++i) {
+    blocks.push_back(counted->Allocate<SegregatedFit, Unlocked>(8 + i * 24));
+    others.push_back(
+        uncounted->Allocate<SegregatedFit, Unlocked, Uncounted>(8 + i * 24));
+  }
+  for (std::size_t i = 0; i < blocks.size(); i += 3) {
+    counted->Deallocate<Unlocked>(blocks[i]);
+    uncounted->Deallocate<Unlocked, Uncounted>(others[i]);
+  }
+  auto expected = counted->GetStats();
+  auto stats = uncounted->GetStats();
+  EXPECT_EQ(stats.bytes_free, expected.bytes_free);
+  EXPECT_EQ(stats.bytes_in_use, expected.bytes_in_use);
+  EXPECT_EQ(stats.largest_free_block, expected.largest_free_block);
+  EXPECT_EQ(stats.free_blocks, expected.free_blocks);
+  for (std::size_t i = 2; i < blocks.size(); i += 3) {
+    counted->Deallocate<Unlocked>(blocks[i]);
+    uncounted->Deallocate<Unlocked>(others[i]);
+  }
+  EXPECT_EQ(uncounted->GetStats().largest_free_block,
+            counted->GetStats().largest_free_block);
+  EXPECT_EQ(uncounted->GetStats().bytes_free, counted->GetStats().bytes_free);
+}
+
+TEST_F(MemoryTests, LargestFreeBlockAfterUncountedFrees) {
+  auto heap = s21::Heap::Create(16 * 1024);
+  std::vector<void *> blocks;
+  for (std::size_t size : {2100, 3000, 3900, 2500}) {
+    blocks.push_back(heap->Malloc(size));
+    heap->Malloc(16);
+  }
+  ASSERT_NE(heap->Malloc(heap->GetStats().largest_free_block), nullptr);
+  auto largest = heap->UsableSize(blocks[2]);
+  for (auto ptr : blocks) heap->Deallocate<Unlocked, Uncounted>(ptr);
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.largest_free_block, largest);
+  EXPECT_EQ(stats.free_blocks, blocks.size());
+  EXPECT_EQ(stats.frees, 0);
+}
+
+TEST_F(MemoryTests, ReallocationMovesByPlacementPolicy) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto large = heap->Malloc(512);
+  heap->Malloc(8);
+  auto small = heap->Malloc(64);
+  heap->Malloc(8);
+  auto ptr = heap->Malloc(16);
+  heap->Malloc(8);
+  heap->Free(large);
+  heap->Free(small);
+  ptr = heap->Reallocate<BestFit, Unlocked>(ptr, 60);
+  EXPECT_EQ(ptr, small);
+  EXPECT_EQ((heap->Reallocate<FirstFit, Unlocked>(ptr, 100)), large);
+}
+
+TEST_F(MemoryTests, ZeroedAllocationFollowsPolicies) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  auto dirty = heap->Allocate<FirstFit, Locked>(1000);
+  std::memset(dirty, 0xAB, 1000);
+  heap->Deallocate<Locked>(dirty);
+  auto ptr =
+      static_cast<unsigned char *>(heap->AllocateZeroed<FirstFit, Locked>(
+          10, 100));
+  EXPECT_EQ(static_cast<void *>(ptr), dirty);
+  for (int i = 0; i < 1000; ++i) EXPECT_EQ(ptr[i], 0);
+  EXPECT_EQ((heap->AllocateZeroed<BestFit, Locked>(SIZE_MAX / 2, 3)),
+            nullptr);
+}
+
+TEST_F(MemoryTests, ThreadCachedPolicyServesThreads) {
+  auto heap = s21::Heap::Create(16 * 1024 * 1024);
+  auto work = [&heap] {
+    std::vector<int *> blocks;
+    for (int i = 0; i < 10000; ++i) {
+      auto ptr = heap->Allocate<SegregatedFit, ThreadCached>(sizeof(int));
+      blocks.push_back(static_cast<int *>(ptr));
+      *blocks.back() = i;
+    }
+    for (int i = 0; i < 10000; ++i) {
+      EXPECT_EQ(*blocks[i], i);
+      heap->Deallocate<ThreadCached>(blocks[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) threads.emplace_back(work);
+  for (auto &thread : threads) thread.join();
+  heap->Defragmentation();
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+}  // namespace Test
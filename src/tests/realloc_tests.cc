@@ -0,0 +1,66 @@
+#include <cstring>
+
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(MemoryTests, ReallocGrowsIntoFreePrevious) {
+  auto heap = s21::Heap::Create(4096);
+  auto a = heap->Malloc(64);
+  auto b = static_cast<char *>(heap->Malloc(64));
+  heap->Malloc(64);
+  heap->Free(a);
+  std::memset(b, 'b', 64);
+  auto blocks = heap->GetStats().used_blocks + heap->GetStats().free_blocks;
+  auto grown = static_cast<char *>(heap->Realloc(b, 64 + header_size + 64));
+  EXPECT_EQ(grown, a);
+  for (int i = 0; i < 64; ++i) EXPECT_EQ(grown[i], 'b');
+  EXPECT_EQ(heap->GetStats().used_blocks + heap->GetStats().free_blocks,
+            blocks - 1);
+}
+
+TEST_F(MemoryTests, ReallocPrefersNextBlock) {
+  auto heap = s21::Heap::Create(4096);
+  auto a = heap->Malloc(64);
+  auto b = heap->Malloc(64);
+  heap->Free(a);
+  EXPECT_EQ(heap->Realloc(b, 256), b);
+  EXPECT_FALSE(heap->GetFirstHeader()->state());
+}
+
+TEST_F(MemoryTests, ReallocShrinkJoinsFreeNext) {
+  auto heap = s21::Heap::Create(4096);
+  auto a = heap->Malloc(256);
+  auto b = heap->Malloc(64);
+  auto c = heap->Malloc(64);
+  heap->Free(b);
+  EXPECT_EQ(heap->Realloc(a, 32), a);
+  auto tail = heap->GetFirstHeader()->next();
+  EXPECT_FALSE(tail->state());
+  EXPECT_EQ(tail->size(), 256 - 32 + 64);
+  EXPECT_EQ(tail->next()->addr(), c);
+  EXPECT_EQ(heap->GetStats().free_blocks, 2);
+}
+
+TEST_F(MemoryTests, ReallocShrinkGivesBackSmallTail) {
+  auto heap = s21::Heap::Create(4096);
+  auto a = heap->Malloc(64);
+  auto b = heap->Malloc(64);
+  heap->Free(b);
+  EXPECT_EQ(heap->Realloc(a, 56), a);
+  EXPECT_EQ(heap->GetFirstHeader()->size(), 56);
+  EXPECT_EQ(heap->GetFirstHeader()->alignment(), 0);
+  EXPECT_EQ(heap->GetFirstHeader()->next()->size(), 4096 - 56 - header_size);
+}
+
+TEST_F(MemoryTests, ReallocShrinkKeepsNeighboursApartWithoutCoalescing) {
+  auto heap = s21::Heap::Create(4096);
+  heap->SetCoalescing(false);
+  auto a = heap->Malloc(256);
+  auto b = heap->Malloc(64);
+  heap->Free(b);
+  heap->Realloc(a, 32);
+  EXPECT_EQ(heap->GetStats().free_blocks, 3);
+}
+
+}  // namespace Test
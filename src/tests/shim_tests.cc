@@ -0,0 +1,67 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+namespace {
+bool IsAligned(const void *ptr, size_type alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+}  // namespace
+
+TEST_F(ShimTests, BlocksAreAlignedForAnyType) {
+  auto malloc = Symbol<void *(std::size_t)>("malloc");
+  auto calloc = Symbol<void *(std::size_t, std::size_t)>("calloc");
+  auto free = Symbol<void(void *)>("free");
+  std::vector<void *> blocks;
+  for (size_type i = 0; i < 1000; ++i) {
+    auto ptr = i % 2 ? malloc(1 + i * 37 % 300) : calloc(1 + i % 7, 1 + i);
+    ASSERT_TRUE(ptr != nullptr);
+    EXPECT_TRUE(IsAligned(ptr, min_alignment)) << ptr;
+    blocks.push_back(ptr);
+    if (i % 3 == 0) {
+      free(blocks[i / 2]);
+      blocks[i / 2] = nullptr;
+    }
+  }
+  for (auto ptr : blocks) free(ptr);
+}
+
+TEST_F(ShimTests, ReallocKeepsAlignmentAndData) {
+  auto malloc = Symbol<void *(std::size_t)>("malloc");
+  auto realloc = Symbol<void *(void *, std::size_t)>("realloc");
+  auto free = Symbol<void(void *)>("free");
+  std::vector<unsigned char *> blocks;
+  for (size_type i = 0; i < 100; ++i) {
+    blocks.push_back(static_cast<unsigned char *>(malloc(24)));
+    std::memset(blocks.back(), static_cast<int>(i), 24);
+  }
+  for (size_type i = 0; i < blocks.size(); ++i) {
+    auto size = 24 + i * 13;
+    blocks[i] = static_cast<unsigned char *>(realloc(blocks[i], size));
+    ASSERT_TRUE(blocks[i] != nullptr);
+    EXPECT_TRUE(IsAligned(blocks[i], min_alignment)) << i;
+    EXPECT_EQ(blocks[i][0], i);
+    EXPECT_EQ(blocks[i][23], i);
+  }
+  for (auto ptr : blocks) free(ptr);
+}
+
+TEST_F(ShimTests, MemalignRejectsHugeSizes) {
+  auto posix_memalign =
+      Symbol<int(void **, std::size_t, std::size_t)>("posix_memalign");
+  auto free = Symbol<void(void *)>("free");
+  void *ptr = nullptr;
+  EXPECT_EQ(posix_memalign(&ptr, 64, SIZE_MAX - 40), ENOMEM);
+  EXPECT_EQ(posix_memalign(&ptr, 64, SIZE_MAX / 2), ENOMEM);
+  EXPECT_EQ(posix_memalign(&ptr, 24, 64), EINVAL);
+  ASSERT_EQ(posix_memalign(&ptr, 64, 100), 0);
+  EXPECT_TRUE(IsAligned(ptr, 64));
+  free(ptr);
+}
+
+}  // namespace Test
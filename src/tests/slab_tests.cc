@@ -0,0 +1,69 @@
+#include "test_core.h"
+
+namespace Test {
+
+TEST_F(SlabTests, SmallBlocksShareSlab) {
+  auto x = static_cast<std::byte *>(s21_malloc(10));
+  auto y = static_cast<std::byte *>(s21_malloc(10));
+  EXPECT_EQ(y - x, 16);
+}
+
+TEST_F(SlabTests, FreedSlotIsReused) {
+  auto x = s21_malloc(10);
+  s21_malloc(10);
+  s21_free(x);
+  EXPECT_EQ(s21_malloc(12), x);
+}
+
+TEST_F(SlabTests, LargeBlocksBypassSlabs) {
+  auto x = static_cast<std::byte *>(s21_malloc(1024));
+  auto header = reinterpret_cast<const s21::Heap::Header *>(x - header_size);
+  EXPECT_TRUE(header->state());
+  EXPECT_EQ(header->size(), 1024);
+}
+
+TEST_F(SlabTests, ReallocMovesSlotOut) {
+  auto x = static_cast<int *>(s21_malloc(2 * sizeof(int)));
+  x[0] = 1;
+  x[1] = 2;
+  EXPECT_EQ(s21_realloc(x, 8), x);
+  x = static_cast<int *>(s21_realloc(x, 100));
+  EXPECT_EQ(x[0], 1);
+  EXPECT_EQ(x[1], 2);
+  x = static_cast<int *>(s21_realloc(x, 1000));
+  EXPECT_EQ(x[0], 1);
+  EXPECT_EQ(x[1], 2);
+  auto header = reinterpret_cast<const s21::Heap::Header *>(
+      reinterpret_cast<std::byte *>(x) - header_size);
+  EXPECT_EQ(header->size(), 1000);
+}
+
+TEST_F(SlabTests, EmptySlabsAreReturned) {
+  std::vector<void *> blocks;
+  for (int i = 0; i < 1000; ++i) blocks.push_back(s21_malloc(24));
+  for (auto block : blocks) s21_free(block);
+  s21_defragmentation();
+  auto header = s21_get_first_header();
+  EXPECT_FALSE(header->state());
+  EXPECT_TRUE(header->next() == nullptr);
+}
+
+TEST_F(SlabTests, DefragmentationKeepsSlabsInPlace) {
+  auto block = s21_malloc(1024);
+  auto x = static_cast<int *>(s21_malloc(sizeof(int)));
+  *x = 42;
+  s21_free(block);
+  s21_defragmentation();
+  EXPECT_EQ(*x, 42);
+  EXPECT_EQ(s21_malloc(sizeof(int)), x + 2);
+}
+
+TEST_F(SlabTests, FallsBackToBlocksWhenNoSlabFits) {
+  s21_init(1024);
+  auto x = static_cast<std::byte *>(s21_malloc(10));
+  auto header = reinterpret_cast<const s21::Heap::Header *>(x - header_size);
+  EXPECT_TRUE(header->state());
+  EXPECT_EQ(header->size(), 10);
+}
+
+}  // namespace Test
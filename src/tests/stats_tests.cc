@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "test_core.h"
+
+namespace Test {
+
+namespace {
+// The stats a walk over the blocks gives, for a heap of one chunk.
+s21::Heap::Stats WalkStats(s21::Heap &heap) {
+  s21::Heap::Stats stats{};
+  for (auto header = heap.GetFirstHeader(); header; header = header->next()) {
+    if (header->state()) {
+      ++stats.used_blocks;
+      stats.bytes_in_use += header->size() + header->alignment();
+    } else {
+      ++stats.free_blocks;
+      stats.bytes_free += header->size();
+      stats.largest_free_block =
+          std::max(stats.largest_free_block, header->size());
+    }
+  }
+  return stats;
+}
+
+void ExpectMatchesWalk(s21::Heap &heap) {
+  auto stats = heap.GetStats();
+  auto walk = WalkStats(heap);
+  EXPECT_EQ(stats.used_blocks, walk.used_blocks);
+  EXPECT_EQ(stats.free_blocks, walk.free_blocks);
+  EXPECT_EQ(stats.bytes_in_use, walk.bytes_in_use);
+  EXPECT_EQ(stats.bytes_free, walk.bytes_free);
+  EXPECT_EQ(stats.largest_free_block, walk.largest_free_block);
+}
+}  // namespace
+
+TEST_F(MemoryTests, StatsOfNewHeap) {
+  auto heap = s21::Heap::Create(1024);
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.capacity, 1024 + header_size);
+  EXPECT_EQ(stats.bytes_free, 1024);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.free_blocks, 1);
+  EXPECT_EQ(stats.used_blocks, 0);
+  EXPECT_EQ(stats.largest_free_block, 1024);
+  EXPECT_EQ(stats.external_fragmentation, 0);
+  EXPECT_EQ(stats.free_blocks_by_size[10], 1);
+}
+
+TEST_F(MemoryTests, StatsCountCalls) {
+  auto heap = s21::Heap::Create(4096);
+  auto x = heap->Malloc(int_size);
+  auto y = heap->Calloc(num_elements, int_size);
+  x = heap->Realloc(x, 2 * int_size);
+  heap->Free(y);
+  heap->Free(nullptr);
+  EXPECT_EQ(heap->Malloc(8192), nullptr);
+  heap->Defragmentation();
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.allocations, 2);
+  EXPECT_EQ(stats.frees, 1);
+  EXPECT_EQ(stats.reallocations, 1);
+  EXPECT_EQ(stats.defragmentations, 1);
+  EXPECT_EQ(stats.used_blocks, 1);
+}
+
+TEST_F(MemoryTests, StatsFollowRandomCalls) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  std::mt19937 gen(21);
+  std::vector<void *> blocks(256, nullptr);
+  for (int i = 0; i < 10000; ++i) {
+    auto &block = blocks[gen() % blocks.size()];
+    auto size = gen() % 200;
+    switch (gen() % 3) {
+      case 0:
+        heap->Free(block);
+        block = gen() % 2 ? heap->Malloc(size) : heap->MallocOnlyFree(size);
+        break;
+      case 1:
+        if (auto ptr = heap->Realloc(block, size)) block = ptr;
+        break;
+      default:
+        heap->Free(block);
+        block = nullptr;
+    }
+    if (i % 100 == 0) {
+      heap->SetCoalescing(gen() % 2);
+      ExpectMatchesWalk(*heap);
+    }
+  }
+  heap->Defragmentation();
+  ExpectMatchesWalk(*heap);
+  EXPECT_EQ(heap->GetStats().external_fragmentation, 0);
+}
+
+TEST_F(MemoryTests, StatsShowFragmentation) {
+  auto heap = s21::Heap::Create(1024);
+  heap->SetCoalescing(false);
+  std::vector<void *> blocks;
+  while (auto ptr = heap->MallocOnlyFree(56)) blocks.push_back(ptr);
+  for (std::size_t i = 0; i < blocks.size(); i += 2) heap->Free(blocks[i]);
+  auto stats = heap->GetStats();
+  EXPECT_EQ(stats.largest_free_block, 56);
+  EXPECT_GT(stats.external_fragmentation, 0.5);
+  EXPECT_EQ(stats.free_blocks_by_size[5], blocks.size() / 2);
+  heap->Defragmentation();
+  EXPECT_EQ(heap->GetStats().external_fragmentation, 0);
+  EXPECT_EQ(heap->GetStats().free_blocks, 1);
+}
+
+TEST_F(MemoryTests, StatsFollowTakenLargestBlock) {
+  auto heap = s21::Heap::Create(64 * 1024);
+  heap->SetCoalescing(false);
+  std::vector<void *> blocks;
+  for (size_type size : {600, 904, 704, 1000, 800}) {
+    blocks.push_back(heap->Malloc(size));
+    heap->Malloc(int_size);
+  }
+  heap->Malloc(heap->GetStats().largest_free_block);
+  for (auto block : blocks) heap->Free(block);
+  EXPECT_EQ(heap->GetStats().largest_free_block, 1000);
+  for (size_type size : {1000, 904, 800, 704, 600}) {
+    EXPECT_EQ(heap->GetStats().largest_free_block, size);
+    EXPECT_NE(heap->MallocOnlyFree(size), nullptr);
+    ExpectMatchesWalk(*heap);
+  }
+  EXPECT_EQ(heap->GetStats().largest_free_block, 0);
+}
+
+TEST_F(ConcurrencyTests, StatsCountCachedCalls) {
+  auto before = s21_get_stats();
+  std::vector<std::thread> threads;
+  for (size_type i = 0; i < num_threads; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < 1000; ++j) s21_free(s21_malloc(int_size));
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  auto stats = s21_get_stats();
+  EXPECT_EQ(stats.allocations - before.allocations, num_threads * 1000);
+  EXPECT_EQ(stats.frees - before.frees, num_threads * 1000);
+}
+
+}  // namespace Test
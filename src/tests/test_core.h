@@ -1,8 +1,11 @@
 #ifndef MEMORY_TESTS_TEST_CORE_H_
 #define MEMORY_TESTS_TEST_CORE_H_
 
+#include <dlfcn.h>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+
 #include "../Heap.h"
 
 namespace Test {
@@ -17,6 +20,90 @@ class MemoryTests : public ::testing::Test {
   constexpr static size_type num_elements = 128;
 };
 
+class ConcurrencyTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    s21_init(heap_size);
+    s21_set_concurrent(true);
+  }
+  void TearDown() override { s21_set_concurrent(false); }
+
+  constexpr static size_type heap_size = 16 * 1024 * 1024;
+  constexpr static size_type int_size = sizeof(int);
+  constexpr static size_type num_threads = 8;
+};
+
+class SlabTests : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    s21_init(heap_size);
+    s21_set_slabs(true);
+  }
+  void TearDown() override { s21_set_slabs(false); }
+
+  constexpr static size_type heap_size = 64 * 1024;
+};
+
+class BuddyTests : public ::testing::Test {
+ protected:
+  void SetUp() override { s21_init_buddy(heap_size); }
+  void TearDown() override { s21_init(heap_size); }
+
+  constexpr static size_type heap_size = 64 * 1024;
+  constexpr static size_type int_size = sizeof(int);
+  constexpr static size_type num_elements = 128;
+};
+
+// Runs a test against the block heap and, with the parameter set, against
+// the buddy engine. Only tests that do not walk headers can use it.
+class EngineTests : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    if (GetParam()) {
+      s21_init_buddy(heap_size);
+    } else {
+      s21_init(heap_size);
+    }
+  }
+  void TearDown() override { s21_init(heap_size); }
+
+  constexpr static size_type heap_size = 64 * 1024;
+};
+
+// Calls the C allocation functions of the LD_PRELOAD shim. The library is
+// bound to itself, so the test's own allocations stay with glibc.
+class ShimTests : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    if (!library) {
+      library = dlopen("./libs21_malloc.so",
+                       RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    }
+  }
+  void SetUp() override { ASSERT_TRUE(library != nullptr) << dlerror(); }
+
+  template <class Function>
+  static Function *Symbol(const char *name) {
+    return reinterpret_cast<Function *>(dlsym(library, name));
+  }
+
+  constexpr static size_type min_alignment = alignof(std::max_align_t);
+  static inline void *library = nullptr;
+};
+
+class TraceTests : public ::testing::Test {
+ protected:
+  void SetUp() override { s21_init(heap_size); }
+  void TearDown() override {
+    s21_stop_recording();
+    std::remove(path);
+  }
+
+  constexpr static size_type heap_size = 4096;
+  constexpr static size_type int_size = sizeof(int);
+  constexpr static const char *path = "trace_test.bin";
+};
+
 }  // namespace Test
 
 #endif  // MEMORY_TESTS_TEST_CORE_H_
@@ -1,3 +1,11 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
 #include "test_core.h"
 
 namespace Test {
@@ -17,10 +25,10 @@ void func(const std::vector<int *> &vars, const s21::Heap::Header *header,
   }
 
   size_type i = 0;
-  for (auto current = header; current; current = current->next) {
+  for (auto current = header; current; current = current->next()) {
     if (i < num_elements - num_free_elements) {
-      std::byte *addr = current->addr;
-      size_type one_element_size = current->size / num_elements_in_one;
+      std::byte *addr = current->addr();
+      size_type one_element_size = current->size() / num_elements_in_one;
       auto *data = new std::byte[one_element_size];
 
       for (size_type j = 0; j < num_elements_in_one; ++j) {
@@ -37,26 +45,26 @@ void func(const std::vector<int *> &vars, const s21::Heap::Header *header,
       }
       delete[] data;
 
-      EXPECT_EQ(current->state, true);
-      EXPECT_EQ(current->size, type_size * num_elements_in_one);
+      EXPECT_EQ(current->state(), true);
+      EXPECT_EQ(current->size(), type_size * num_elements_in_one);
 
-      if (current->next) {
-        EXPECT_EQ(current->next->addr - header_size,
-                  current->addr + current->size + current->alignment);
+      if (current->next()) {
+        EXPECT_EQ(current->next()->addr() - header_size,
+                  current->addr() + current->size() + current->alignment());
       }
 
       //            if (num_free_elements == 0 && i == num_elements - 1)
       //            {
-      //                EXPECT_EQ(current->alignment, )
+      //                EXPECT_EQ(current->alignment(), )
       //            }
       //            if (i != num_elements - num_free_elements - 1)
       //            {
-      //                EXPECT_EQ(current->alignment, alignment);
+      //                EXPECT_EQ(current->alignment(), alignment);
       //            }
 
-      //            EXPECT_EQ(current->type, s21::Heap::Type::Int);
+      //            EXPECT_EQ(current->type(), s21::Heap::Type::Int);
     } else {
-      EXPECT_EQ(current->state, false);
+      EXPECT_EQ(current->state(), false);
     }
   }
 }
@@ -128,34 +136,34 @@ TEST_F(MemoryTests, ReallocEmptyPointer) {
   s21_init(64);
   int *x = nullptr;
   EXPECT_TRUE(s21_realloc(x, int_size) != nullptr);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocImpossibleToIncrease) {
-  s21_init(64);
+  s21_init(header_size + 2 * int_size);
   int *x = reinterpret_cast<int *>(s21_malloc(int_size));
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  s21_realloc(x, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  s21_realloc(x, int_size * 16);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocIncrease) {
   s21_init(128);
   int *x = reinterpret_cast<int *>(s21_malloc(int_size));
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
   s21_realloc(x, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->size, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size * 3);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocReduce) {
   s21_init(64);
   int *x = reinterpret_cast<int *>(s21_malloc(int_size * 2));
-  EXPECT_EQ(s21_get_first_header()->size, int_size * 2);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size * 2);
   s21_realloc(x, int_size);
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocNoNearestFreeBlock) {
@@ -164,20 +172,20 @@ TEST_F(MemoryTests, ReallocNoNearestFreeBlock) {
   s21_malloc(int_size);
   s21_realloc(x, int_size * 3);
   auto header = s21_get_first_header();
-  EXPECT_FALSE(header->state);
-  header = header->next;
-  EXPECT_TRUE(header->state);
-  header = header->next;
-  EXPECT_TRUE(header->state);
-  EXPECT_EQ(header->size, int_size * 3);
+  EXPECT_FALSE(header->state());
+  header = header->next();
+  EXPECT_TRUE(header->state());
+  header = header->next();
+  EXPECT_TRUE(header->state());
+  EXPECT_EQ(header->size(), int_size * 3);
 }
 
-TEST_F(MemoryTests, FreeNullptr) {
+TEST_P(EngineTests, FreeNullptr) {
   int *x = nullptr;
   s21_free(x);
 }
 
-TEST_F(MemoryTests, FreeInvalidPointer) {
+TEST_P(EngineTests, FreeInvalidPointer) {
   int x = 10;
   int *y = &x;
   EXPECT_ANY_THROW(s21_free(y));
@@ -188,10 +196,184 @@ TEST_F(MemoryTests, Free) {
   int *x = reinterpret_cast<int *>(s21_malloc(int_size));
   s21_free(x);
   auto header = s21_get_first_header();
-  EXPECT_TRUE(header->next == nullptr);
-  EXPECT_FALSE(header->state);
+  EXPECT_TRUE(header->next() == nullptr);
+  EXPECT_FALSE(header->state());
+}
+
+TEST_F(MemoryTests, FreeCoalescesWithBothNeighbours) {
+  s21_init(1024);
+  auto x = s21_malloc(int_size);
+  auto y = s21_malloc(int_size);
+  auto z = s21_malloc(int_size);
+  auto w = s21_malloc(int_size);
+  s21_free(x);
+  s21_free(z);
+  s21_free(y);
+  auto header = s21_get_first_header();
+  EXPECT_FALSE(header->state());
+  EXPECT_EQ(header->size(), 3 * 2 * int_size + 2 * header_size);
+  EXPECT_EQ(header->next()->addr(), w);
+  EXPECT_EQ(header->next()->prev(), header);
+  EXPECT_EQ(s21_malloc(header->size()), x);
+}
+
+TEST_F(MemoryTests, FreeWithoutCoalescingKeepsFragments) {
+  s21_init(1024);
+  s21_set_coalescing(false);
+  auto x = s21_malloc(int_size);
+  auto y = s21_malloc(int_size);
+  s21_malloc(int_size);
+  s21_free(x);
+  s21_free(y);
+  s21_set_coalescing(true);
+  auto header = s21_get_first_header();
+  EXPECT_FALSE(header->state());
+  EXPECT_EQ(header->size(), 2 * int_size);
+  EXPECT_FALSE(header->next()->state());
+  EXPECT_EQ(header->next()->size(), 2 * int_size);
 }
 
+TEST_F(MemoryTests, MallocGrowsHeapUpToLimit) {
+  auto heap = s21::Heap::Create(256);
+  auto capacity = heap->Capacity();
+  heap->SetGrowth(2, 4096);
+  EXPECT_TRUE(heap->Malloc(1024) != nullptr);
+  EXPECT_TRUE(heap->MallocOnlyFree(1024) != nullptr);
+  EXPECT_GT(heap->Capacity(), capacity);
+  EXPECT_LE(heap->Capacity(), 4096);
+  EXPECT_EQ(heap->Malloc(4096), nullptr);
+}
+
+TEST_F(MemoryTests, GrowthRejectsHugeSizes) {
+  auto heap = s21::Heap::Create(256);
+  heap->SetGrowth(2, SIZE_MAX);
+  auto capacity = heap->Capacity();
+  EXPECT_EQ(heap->Malloc(SIZE_MAX - 8), nullptr);
+  EXPECT_EQ(heap->MallocOnlyFree(SIZE_MAX - 8), nullptr);
+  heap->SetPlacement(s21::Heap::Placement::NextFit);
+  EXPECT_EQ(heap->Malloc(SIZE_MAX - 8), nullptr);
+  heap->SetPlacement(s21::Heap::Placement::BestFit);
+  EXPECT_EQ(heap->Malloc(SIZE_MAX - 8), nullptr);
+  EXPECT_EQ(heap->Capacity(), capacity);
+}
+
+TEST_F(MemoryTests, HugeGrowthFactorStopsAtLimit) {
+  auto heap = s21::Heap::Create(256);
+  heap->SetGrowth(1e300, 64 * 1024);
+  EXPECT_TRUE(heap->Malloc(512) != nullptr);
+  EXPECT_EQ(heap->Capacity(), 64 * 1024);
+  heap->SetGrowth(std::numeric_limits<double>::infinity(), 256 * 1024);
+  EXPECT_TRUE(heap->Malloc(100 * 1024) != nullptr);
+  EXPECT_EQ(heap->Capacity(), 256 * 1024);
+  EXPECT_ANY_THROW(heap->SetGrowth(std::nan(""), 256 * 1024));
+}
+
+TEST_F(MemoryTests, HeapWithoutGrowthKeepsSize) {
+  auto heap = s21::Heap::Create(256);
+  auto capacity = heap->Capacity();
+  EXPECT_EQ(heap->Malloc(1024), nullptr);
+  EXPECT_EQ(heap->Capacity(), capacity);
+}
+
+TEST_F(MemoryTests, FreeReleasesEmptyChunk) {
+  auto heap = s21::Heap::Create(256);
+  auto capacity = heap->Capacity();
+  heap->SetGrowth(2, 4096);
+  auto x = heap->Malloc(1024);
+  heap->Free(x);
+  EXPECT_EQ(heap->Capacity(), capacity);
+}
+
+TEST_F(MemoryTests, DefragmentationReportsMovedBlocks) {
+  auto heap = s21::Heap::Create(4096);
+  auto a = heap->Malloc(64);
+  auto b = static_cast<int *>(heap->Malloc(64));
+  auto c = heap->Malloc(32);
+  *b = 21;
+  heap->Free(a);
+  std::vector<std::pair<void *, void *>> moves;
+  heap->Defragmentation(
+      [&moves](void *from, void *to) { moves.emplace_back(from, to); });
+  ASSERT_EQ(moves.size(), 2);
+  EXPECT_EQ(moves[0], std::make_pair(static_cast<void *>(b), a));
+  EXPECT_EQ(*static_cast<int *>(moves[0].second), 21);
+  EXPECT_EQ(moves[1].first, c);
+  heap->Free(moves[0].second);
+  heap->Free(moves[1].second);
+  EXPECT_EQ(heap->GetStats().used_blocks, 0);
+}
+
+TEST_F(MemoryTests, DefragmentationReleasesEmptyChunk) {
+  auto heap = s21::Heap::Create(256);
+  auto capacity = heap->Capacity();
+  heap->SetGrowth(2, 4096);
+  heap->SetCoalescing(false);
+  auto x = heap->Malloc(400);
+  auto y = heap->Malloc(int_size);
+  heap->Free(x);
+  heap->Free(y);
+  EXPECT_GT(heap->Capacity(), capacity);
+  heap->Defragmentation();
+  EXPECT_EQ(heap->Capacity(), capacity);
+  EXPECT_TRUE(heap->Malloc(200) != nullptr);
+}
+
+TEST_F(MemoryTests, MmapStorage) {
+  for (auto storage :
+       {s21::Heap::Storage::Mmap, s21::Heap::Storage::MmapHugePages}) {
+    auto heap = s21::Heap::Create(1024 * 1024, storage);
+    auto x = static_cast<int *>(heap->Malloc(num_elements * int_size));
+    auto y = static_cast<int *>(heap->Calloc(num_elements, int_size));
+    for (size_type i = 0; i < num_elements; ++i) {
+      x[i] = static_cast<int>(i);
+      EXPECT_EQ(y[i], 0);
+    }
+    heap->Free(y);
+    x = static_cast<int *>(heap->Realloc(x, 2 * num_elements * int_size));
+    heap->Defragmentation();
+    x = reinterpret_cast<int *>(heap->GetFirstHeader()->addr());
+    for (size_type i = 0; i < num_elements; ++i) {
+      EXPECT_EQ(x[i], static_cast<int>(i));
+    }
+  }
+}
+
+#ifdef __linux__
+TEST_F(MemoryTests, MmapFreeReturnsLargeRegionToSystem) {
+  constexpr size_type size = 512 * 1024;
+  auto heap = s21::Heap::Create(2 * size, s21::Heap::Storage::Mmap);
+  auto x = static_cast<unsigned char *>(heap->Malloc(size));
+  heap->Malloc(int_size);
+  std::fill_n(x, size, 0xAB);
+  heap->Free(x);
+  EXPECT_EQ(x[size / 2], 0);
+  EXPECT_TRUE(heap->Malloc(size) != nullptr);
+}
+
+TEST_F(MemoryTests, MmapFreeReturnsMergedNeighbour) {
+  constexpr size_type size = 100 * 1024;
+  auto heap = s21::Heap::Create(4 * size, s21::Heap::Storage::Mmap);
+  auto x = static_cast<unsigned char *>(heap->Malloc(size));
+  auto y = static_cast<unsigned char *>(heap->Malloc(size));
+  heap->Malloc(int_size);
+  std::fill_n(x, size, 0xAB);
+  std::fill_n(y, size, 0xCD);
+  heap->Free(x);
+  heap->Free(y);
+  std::size_t page_size = sysconf(_SC_PAGESIZE);
+  auto first = (reinterpret_cast<std::uintptr_t>(x) + page_size) &
+               ~(page_size - 1);
+  auto last = (reinterpret_cast<std::uintptr_t>(x) + size) & ~(page_size - 1);
+  std::vector<unsigned char> pages((last - first) / page_size);
+  ASSERT_EQ(mincore(reinterpret_cast<void *>(first), last - first,
+                    pages.data()),
+            0);
+  EXPECT_EQ(std::count_if(pages.begin(), pages.end(),
+                          [](unsigned char page) { return page & 1; }),
+            0);
+}
+#endif
+
 TEST_F(MemoryTests, MallocOnlyFreeFullyOccupiedHeap) {
   s21_init((int_size + header_size) * num_elements);
   std::vector<int *> vars{num_elements, nullptr};
@@ -262,34 +444,34 @@ TEST_F(MemoryTests, ReallocOnlyFreeEmptyPointer) {
   s21_init(64);
   int *x = nullptr;
   EXPECT_TRUE(s21_realloc_onlyfree(x, int_size) != nullptr);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocOnlyFreeImpossibleToIncrease) {
-  s21_init(64);
+  s21_init(header_size + 2 * int_size);
   int *x = reinterpret_cast<int *>(s21_malloc_onlyfree(int_size));
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  s21_realloc_onlyfree(x, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  s21_realloc_onlyfree(x, int_size * 16);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocOnlyFreeIncrease) {
   s21_init(128);
   int *x = reinterpret_cast<int *>(s21_malloc_onlyfree(int_size));
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
   s21_realloc_onlyfree(x, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->size, int_size * 3);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size * 3);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocOnlyFreeReduce) {
   s21_init(64);
   int *x = reinterpret_cast<int *>(s21_malloc_onlyfree(int_size * 2));
-  EXPECT_EQ(s21_get_first_header()->size, int_size * 2);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size * 2);
   s21_realloc_onlyfree(x, int_size);
-  EXPECT_EQ(s21_get_first_header()->size, int_size);
-  EXPECT_EQ(s21_get_first_header()->state, true);
+  EXPECT_EQ(s21_get_first_header()->size(), int_size);
+  EXPECT_EQ(s21_get_first_header()->state(), true);
 }
 
 TEST_F(MemoryTests, ReallocOnlyFreeNoNearestFreeBlock) {
@@ -298,20 +480,59 @@ TEST_F(MemoryTests, ReallocOnlyFreeNoNearestFreeBlock) {
   s21_malloc_onlyfree(int_size);
   s21_realloc_onlyfree(x, int_size * 3);
   auto header = s21_get_first_header();
-  EXPECT_FALSE(header->state);
-  header = header->next;
-  EXPECT_TRUE(header->state);
-  header = header->next;
-  EXPECT_TRUE(header->state);
-  EXPECT_EQ(header->size, int_size * 3);
+  EXPECT_FALSE(header->state());
+  header = header->next();
+  EXPECT_TRUE(header->state());
+  header = header->next();
+  EXPECT_TRUE(header->state());
+  EXPECT_EQ(header->size(), int_size * 3);
 }
 
-TEST_F(MemoryTests, FreeOnlyFreeNullptr) {
+TEST_F(MemoryTests, MallocOnlyFreeTakesBlockFromFittingSizeClass) {
+  s21_init(1024);
+  auto large = s21_malloc_onlyfree(16 * int_size);
+  s21_malloc_onlyfree(int_size);
+  auto small = s21_malloc_onlyfree(4 * int_size);
+  s21_malloc_onlyfree(int_size);
+  s21_free_onlyfree(large);
+  s21_free_onlyfree(small);
+  EXPECT_EQ(s21_malloc_onlyfree(4 * int_size), small);
+  EXPECT_EQ(s21_malloc_onlyfree(16 * int_size), large);
+}
+
+TEST_F(MemoryTests, MallocOnlyFreeScansOwnSizeClass) {
+  s21_init(1024);
+  auto x = s21_malloc_onlyfree(5 * int_size);
+  s21_malloc_onlyfree(int_size);
+  s21_malloc_onlyfree(s21_get_first_header()->next()->next()->size());
+  s21_free_onlyfree(x);
+  EXPECT_EQ(s21_malloc_onlyfree(5 * int_size), x);
+}
+
+TEST_F(MemoryTests, MallocUnlinksBlockFromMiddleOfSizeClass) {
+  s21_init(1024);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 6; ++i) blocks.push_back(s21_malloc_onlyfree(int_size));
+  auto tail = s21_get_first_header();
+  while (tail->next()) tail = tail->next();
+  s21_malloc_onlyfree(tail->size());
+  s21_free_onlyfree(blocks[1]);
+  s21_free_onlyfree(blocks[3]);
+  s21_free_onlyfree(blocks[5]);
+  EXPECT_EQ(s21_malloc(int_size), blocks[1]);
+  auto first = s21_malloc_onlyfree(int_size);
+  auto second = s21_malloc_onlyfree(int_size);
+  EXPECT_TRUE((first == blocks[3] && second == blocks[5]) ||
+              (first == blocks[5] && second == blocks[3]));
+  EXPECT_EQ(s21_malloc_onlyfree(int_size), nullptr);
+}
+
+TEST_P(EngineTests, FreeOnlyFreeNullptr) {
   int *x = nullptr;
   s21_free_onlyfree(x);
 }
 
-TEST_F(MemoryTests, FreeOnlyFreeInvalidPointer) {
+TEST_P(EngineTests, FreeOnlyFreeInvalidPointer) {
   int x = 10;
   int *y = &x;
   EXPECT_ANY_THROW(s21_free_onlyfree(y));
@@ -322,8 +543,8 @@ TEST_F(MemoryTests, FreeOnlyFree) {
   int *x = reinterpret_cast<int *>(s21_malloc_onlyfree(int_size));
   s21_free_onlyfree(x);
   auto header = s21_get_first_header();
-  EXPECT_TRUE(header->next == nullptr);
-  EXPECT_FALSE(header->state);
+  EXPECT_TRUE(header->next() == nullptr);
+  EXPECT_FALSE(header->state());
 }
 
 TEST_F(MemoryTests, Defragmentation_00) {
@@ -348,13 +569,13 @@ TEST_F(MemoryTests, Defragmentation_01) {
   RandomlyFreeBlocks(addresses, free_elems);
   s21_defragmentation();
   auto current = s21_get_first_header();
-  for (int i = 5; i; --i, current = current->next) {
-    EXPECT_TRUE(current->state);
-    EXPECT_EQ(current->size, 2 * int_size);
-    EXPECT_EQ(current->alignment, 0);
+  for (int i = 5; i; --i, current = current->next()) {
+    EXPECT_TRUE(current->state());
+    EXPECT_EQ(current->size(), 2 * int_size);
+    EXPECT_EQ(current->alignment(), 0);
   }
-  EXPECT_EQ(current->size, 264);
-  EXPECT_FALSE(current->state);
+  EXPECT_EQ(current->size(), 5 * (2 * int_size + header_size) - header_size);
+  EXPECT_FALSE(current->state());
 }
 
 TEST_F(MemoryTests, Defragmentation_02) {
@@ -370,10 +591,10 @@ TEST_F(MemoryTests, Defragmentation_02) {
   s21_defragmentation();
   auto header = s21_get_first_header();
   for (int i = 4; i && header; --i) {
-    header = header->next;
+    header = header->next();
   }
-  EXPECT_FALSE(header->state);
-  EXPECT_EQ(header->size, 40);
+  EXPECT_FALSE(header->state());
+  EXPECT_EQ(header->size(), 2 * (128 - 80) - header_size);
 }
 
 TEST_F(MemoryTests, Defragmentation_03) {
@@ -383,11 +604,17 @@ TEST_F(MemoryTests, Defragmentation_03) {
     addresses.push_back(reinterpret_cast<int *>(s21_malloc_onlyfree(128)));
   }
   s21_free_onlyfree(addresses[0]);
-  s21_malloc_onlyfree(80);
+  s21_malloc_onlyfree(128 - header_size);
   s21_defragmentation();
   auto header = s21_get_first_header();
-  header = header->next;
-  EXPECT_TRUE(header->state);
-  EXPECT_EQ(header->alignment, 48);
+  header = header->next();
+  EXPECT_TRUE(header->state());
+  EXPECT_EQ(header->alignment(), header_size);
 }
+
+INSTANTIATE_TEST_SUITE_P(BlockAndBuddy, EngineTests, ::testing::Bool(),
+                         [](const auto &info) {
+                           return info.param ? "Buddy" : "Block";
+                         });
+
 }  // namespace Test
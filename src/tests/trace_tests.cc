@@ -0,0 +1,130 @@
+#include <fstream>
+
+#include "../Trace.h"
+#include "test_core.h"
+
+namespace Test {
+
+std::vector<s21::TraceOp> ReadTrace(const std::string &path) {
+  s21::TraceReader reader(path);
+  std::vector<s21::TraceOp> ops;
+  for (s21::TraceOp op; reader.Next(op);) ops.push_back(op);
+  return ops;
+}
+
+TEST_F(TraceTests, RecordsCalls) {
+  s21_start_recording(path);
+  auto x = s21_malloc(10);
+  auto y = s21_calloc(3, int_size);
+  x = s21_realloc(x, 100);
+  s21_free(y);
+  s21_free(x);
+  s21_defragmentation();
+  s21_stop_recording();
+
+  auto ops = ReadTrace(path);
+  ASSERT_EQ(ops.size(), 6);
+  using Kind = s21::TraceOp::Kind;
+  EXPECT_EQ(ops[0].kind, Kind::Malloc);
+  EXPECT_EQ(ops[0].size, 10);
+  EXPECT_EQ(ops[0].id, 1);
+  EXPECT_EQ(ops[1].kind, Kind::Calloc);
+  EXPECT_EQ(ops[1].num, 3);
+  EXPECT_EQ(ops[1].size, int_size);
+  EXPECT_EQ(ops[1].id, 2);
+  EXPECT_EQ(ops[2].kind, Kind::Realloc);
+  EXPECT_EQ(ops[2].old_id, 1);
+  EXPECT_EQ(ops[2].size, 100);
+  EXPECT_EQ(ops[2].id, 3);
+  EXPECT_EQ(ops[3].kind, Kind::Free);
+  EXPECT_EQ(ops[3].id, 2);
+  EXPECT_EQ(ops[4].kind, Kind::Free);
+  EXPECT_EQ(ops[4].id, 3);
+  EXPECT_EQ(ops[5].kind, Kind::Defragmentation);
+  for (std::size_t i = 1; i < ops.size(); ++i) {
+    EXPECT_LE(ops[i - 1].time, ops[i].time);
+  }
+}
+
+TEST_F(TraceTests, MovedBlocksKeepTheirIds) {
+  s21_start_recording(path);
+  auto x = s21_malloc(10);
+  s21_malloc(20);
+  s21_free(x);
+  s21_defragmentation();
+  s21_free(s21_get_first_header()->addr());
+  s21_stop_recording();
+
+  auto ops = ReadTrace(path);
+  ASSERT_EQ(ops.size(), 5);
+  EXPECT_EQ(ops[4].kind, s21::TraceOp::Kind::Free);
+  EXPECT_EQ(ops[4].id, 2);
+}
+
+TEST_F(TraceTests, RecordsAlignedAllocations) {
+  s21_start_recording(path);
+  s21_free(s21_aligned_alloc(64, 10));
+  s21_stop_recording();
+
+  auto ops = ReadTrace(path);
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].kind, s21::TraceOp::Kind::AlignedMalloc);
+  EXPECT_EQ(ops[0].num, 64);
+  EXPECT_EQ(ops[0].size, 10);
+  EXPECT_EQ(ops[1].id, ops[0].id);
+}
+
+TEST_F(TraceTests, RecordsHeapSize) {
+  s21_start_recording(path);
+  s21_stop_recording();
+  s21::TraceReader reader(path);
+  EXPECT_EQ(reader.HeapSize(), heap_size + header_size);
+}
+
+TEST_F(TraceTests, FailedAllocationHasNoId) {
+  s21_start_recording(path);
+  auto x = s21_malloc(int_size);
+  EXPECT_TRUE(s21_malloc(2 * heap_size) == nullptr);
+  EXPECT_TRUE(s21_realloc(x, 2 * heap_size) == nullptr);
+  s21_stop_recording();
+
+  auto ops = ReadTrace(path);
+  ASSERT_EQ(ops.size(), 3);
+  EXPECT_EQ(ops[1].id, 0);
+  EXPECT_EQ(ops[2].old_id, 1);
+  EXPECT_EQ(ops[2].id, 0);
+}
+
+TEST_F(TraceTests, LargeValuesSurvive) {
+  s21_start_recording(path);
+  s21_calloc(std::size_t{1} << 40, std::size_t{1} << 20);
+  s21_stop_recording();
+
+  auto ops = ReadTrace(path);
+  ASSERT_EQ(ops.size(), 1);
+  EXPECT_EQ(ops[0].num, std::size_t{1} << 40);
+  EXPECT_EQ(ops[0].size, std::size_t{1} << 20);
+}
+
+TEST_F(TraceTests, RejectsOtherFiles) {
+  std::ofstream(path) << "not a trace";
+  EXPECT_ANY_THROW(s21::TraceReader reader(path));
+}
+
+TEST_F(TraceTests, RejectsTruncatedTrace) {
+  s21_start_recording(path);
+  s21_malloc(1000);
+  s21_stop_recording();
+  std::string content;
+  {
+    std::ifstream in(path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  content.resize(content.size() - 2);
+  std::ofstream(path, std::ios::binary) << content;
+  s21::TraceReader reader(path);
+  s21::TraceOp op;
+  EXPECT_ANY_THROW(reader.Next(op));
+}
+
+}  // namespace Test
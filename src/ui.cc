@@ -31,7 +31,8 @@ bool ProcessMenu() {
                "4. Output of the current heap\n"
                "5. Research\n"
                "6. Defragmentation\n"
-               "7. Exit\n";
+               "7. Research of threads\n"
+               "8. Exit\n";
   int ch;
   std::cin >> ch;
   try {
@@ -58,16 +59,27 @@ bool ProcessMenu() {
         while (!(std::cin >> percent) || percent < 5 || percent > 95) {
           std::cout << "try again\n";
         }
-        auto [without_only, with_only] = s21_research(percent);
-        std::cout << "Time with common funcs : \t" << without_only.count();
-        std::cout << "\nTime with vector of free blocks : \t"
-                  << with_only.count() << "\n";
+        for (const auto &[name, time] : s21_research(percent)) {
+          std::cout << "Time with " << name << " : \t" << time.count()
+                    << "\n";
+        }
       } break;
       case 6:
         s21_defragmentation();
         std::cout << "Defragmented\n";
         break;
-      case 7:
+      case 7: {
+        std::cout << "Enter maximum number of threads\n";
+        std::size_t threads;
+        while (!(std::cin >> threads) || threads < 1 || threads > 64) {
+          std::cout << "try again\n";
+        }
+        for (const auto &[name, time] : s21_research_threads(threads)) {
+          std::cout << "Time with " << name << " : \t" << time.count()
+                    << "\n";
+        }
+      } break;
+      case 8:
         return false;
       default:
         std::cout << "try again...\n";